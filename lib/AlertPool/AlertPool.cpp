@@ -0,0 +1,33 @@
+#include "AlertPool.h"
+
+FixedPool<Alert, ALERT_POOL_SIZE> alertPool("alert");
+FixedPool<AtTransaction, AT_TXN_POOL_SIZE> atTxnPool("at_txn");
+FixedPool<MessageBuffer, MSG_BUFFER_POOL_SIZE> msgBufferPool("msg_buf");
+
+static uint32_t nextAlertId = 1;
+
+Alert *alert_pool_acquire()
+{
+  Alert *alert = alertPool.acquire();
+  if (alert == nullptr)
+  {
+    return nullptr;
+  }
+
+  alert->id = nextAlertId++;
+  alert->startTime = 0;
+  alert->startMonoUs = 0;
+  alert->message = msgBufferPool.acquire();
+  return alert;
+}
+
+void alert_pool_release(Alert *alert)
+{
+  if (alert == nullptr)
+  {
+    return;
+  }
+  msgBufferPool.release(alert->message);
+  alert->message = nullptr;
+  alertPool.release(alert);
+}
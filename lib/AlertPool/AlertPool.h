@@ -0,0 +1,122 @@
+/*
+ * Fixed-size pools for alerts, AT command lines and SMS buffers.
+ *
+ * Everything is sized at compile time so long uptimes do not fragment
+ * the heap. Plain C++ (no Arduino headers) so it also builds in the
+ * native test environment.
+ */
+
+#ifndef ALERT_POOL_H
+#define ALERT_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ALERT_POOL_SIZE
+#define ALERT_POOL_SIZE 2 // Concurrent power-loss alerts (SMS + call)
+#endif
+#ifndef AT_TXN_POOL_SIZE
+#define AT_TXN_POOL_SIZE 2 // Concurrent AT command transactions
+#endif
+#ifndef MSG_BUFFER_POOL_SIZE
+#define MSG_BUFFER_POOL_SIZE 2 // SMS message buffers
+#endif
+#ifndef AT_CMD_MAX_LEN
+#define AT_CMD_MAX_LEN 96 // Longest AT command line (without CR/LF)
+#endif
+#ifndef MSG_MAX_LEN
+#define MSG_MAX_LEN 161 // 160 GSM characters + terminator
+#endif
+
+// SMS message buffer
+struct MessageBuffer
+{
+  char text[MSG_MAX_LEN];
+};
+
+// One power-loss notification: SMS followed by an emergency call
+struct Alert
+{
+  uint32_t id;
+  unsigned long startTime;
+  int64_t startMonoUs; // esp_timer_get_time() when the alert started
+  MessageBuffer *message;
+};
+
+// One AT command line being sent to the module
+struct AtTransaction
+{
+  char cmd[AT_CMD_MAX_LEN];
+};
+
+// Fixed-size object pool with allocation counters
+template <typename T, uint8_t N>
+struct FixedPool
+{
+  const char *name;
+  T slots[N];
+  bool used[N];
+  uint8_t inUse;
+  uint8_t peak;
+  uint32_t acquired;
+  uint32_t released;
+  uint32_t failures;
+
+  explicit FixedPool(const char *poolName)
+      : name(poolName), slots(), used(), inUse(0), peak(0), acquired(0), released(0), failures(0)
+  {
+  }
+
+  uint8_t capacity() const
+  {
+    return N;
+  }
+
+  T *acquire()
+  {
+    for (uint8_t i = 0; i < N; i++)
+    {
+      if (!used[i])
+      {
+        used[i] = true;
+        inUse++;
+        if (inUse > peak)
+        {
+          peak = inUse;
+        }
+        acquired++;
+        return &slots[i];
+      }
+    }
+    failures++; // Pool exhausted - caller must fall back
+    return nullptr;
+  }
+
+  void release(T *item)
+  {
+    if (item == nullptr)
+    {
+      return;
+    }
+    size_t i = item - slots;
+    if (i < N && used[i])
+    {
+      used[i] = false;
+      inUse--;
+      released++;
+    }
+  }
+};
+
+extern FixedPool<Alert, ALERT_POOL_SIZE> alertPool;
+extern FixedPool<AtTransaction, AT_TXN_POOL_SIZE> atTxnPool;
+extern FixedPool<MessageBuffer, MSG_BUFFER_POOL_SIZE> msgBufferPool;
+
+// Take an alert (with a fresh id) and its SMS buffer; nullptr if the alert pool
+// is exhausted, message is nullptr if only the buffer pool is
+Alert *alert_pool_acquire();
+
+// Return an alert and its SMS buffer to the pools
+void alert_pool_release(Alert *alert);
+
+#endif
@@ -0,0 +1,81 @@
+#include "AlertSms.h"
+
+#include <SimPort.h>
+#include <VoiceCall.h>
+#include <stdio.h>
+
+Alert *currentAlert = nullptr;
+
+void alert_sms_send(const char *number, const char *text)
+{
+  // Step 1: Set SMS text mode
+  sim_port_logf("1. Setting SMS text mode...\n");
+  sim_port_send("AT+CMGF=1"); // Text mode
+  sim_port_wait(1000);        // Wait for command to be processed
+
+  // Step 2: Set phone number - the text prompt is open until Ctrl+Z has been processed
+  sim_port_logf("2. Setting recipient number...\n");
+  sim_port_set_prompt(true);
+  sim_port_sendf("AT+CMGS=\"%s\"", number);
+  sim_port_wait(2000); // Wait longer for prompt
+
+  // Step 3: Send message content
+  sim_port_logf("3. Sending message content...\n");
+  sim_port_logf("Content: %s\n", text);
+  sim_port_send(text);
+  sim_port_wait(1000); // Wait before sending end character
+
+  // Step 4: End message with Ctrl+Z
+  sim_port_logf("4. Ending message...\n");
+  sim_port_send_byte(0x1A); // End message
+  sim_port_wait(500);       // Final delay
+  sim_port_set_prompt(false);
+}
+
+// Take an alert and its SMS buffer from the fixed pools (nullptr if exhausted)
+static Alert *acquire_alert(int64_t monoUs)
+{
+  Alert *alert = alert_pool_acquire();
+  if (alert == nullptr)
+  {
+    sim_port_logf("!!! Alert pool exhausted - sending without alert tracking\n");
+    return nullptr;
+  }
+
+  alert->startTime = sim_port_millis();
+  alert->startMonoUs = monoUs;
+  if (alert->message == nullptr)
+  {
+    sim_port_logf("!!! Message buffer pool exhausted - using static SMS text\n");
+  }
+  return alert;
+}
+
+bool alert_sms_start(const char *number, const char *text, const char *stamp, int64_t monoUs)
+{
+  if (callInProgress)
+  {
+    // currentAlert belongs to the call, and the SMS steps would hold up its voice alert
+    sim_port_logf("Alert SMS not started - call in progress\n");
+    return false;
+  }
+
+  alert_finish(); // A new SMS supersedes the previous alert
+  currentAlert = acquire_alert(monoUs);
+
+  // Pooled buffer, static text if pools are exhausted
+  const char *content = text;
+  if (currentAlert != nullptr && currentAlert->message != nullptr)
+  {
+    snprintf(currentAlert->message->text, MSG_MAX_LEN, "%s (%s)", text, stamp);
+    content = currentAlert->message->text;
+  }
+  alert_sms_send(number, content);
+  return true;
+}
+
+void alert_finish()
+{
+  alert_pool_release(currentAlert);
+  currentAlert = nullptr;
+}
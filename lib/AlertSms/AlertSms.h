@@ -0,0 +1,27 @@
+/*
+ * Emergency SMS for a power-loss alert: takes the alert and its message
+ * buffer from the pools, composes the text and sends it through SimPort.
+ *
+ * main.cpp and the native soak test run this same code.
+ */
+
+#ifndef ALERT_SMS_H
+#define ALERT_SMS_H
+
+#include <AlertPool.h>
+#include <stdint.h>
+
+extern Alert *currentAlert; // Alert being notified (SMS -> call)
+
+// Send one SMS: text mode, recipient, text, Ctrl+Z (blocks about 4.5 s)
+void alert_sms_send(const char *number, const char *text);
+
+// Replace currentAlert with a new alert started at monoUs and send its SMS as
+// "text (stamp)". Static text is sent when the pools are exhausted.
+// Refused (false) while a call is in progress: the call owns currentAlert.
+bool alert_sms_start(const char *number, const char *text, const char *stamp, int64_t monoUs);
+
+// Release currentAlert once its SMS and call are done
+void alert_finish();
+
+#endif
@@ -0,0 +1,135 @@
+#include "SimPort.h"
+
+#include <AlertPool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_LOG_MAX_LEN 160 // Longest console line printed through the port
+
+uint32_t atFallbackCount = 0;
+uint32_t atTruncatedCount = 0;
+
+static const SimPort *simPort = nullptr;
+static SimLineHandler simLineHandler = nullptr;
+
+static bool simPromptOpen = false;
+
+static char simLineBuf[SIM_LINE_MAX_LEN];
+static uint8_t simLineLen = 0;
+static bool simLineOverflow = false;
+
+void sim_port_begin(const SimPort *port, SimLineHandler handler)
+{
+  simPort = port;
+  simLineHandler = handler;
+  simLineLen = 0;
+  simLineOverflow = false;
+}
+
+bool sim_port_send(const char *cmd)
+{
+  return simPort->sendLine(cmd);
+}
+
+bool sim_port_send_byte(char c)
+{
+  return simPort->sendByte(c);
+}
+
+void sim_port_wait(unsigned long ms)
+{
+  simPort->waitMs(ms);
+}
+
+void sim_port_set_prompt(bool open)
+{
+  simPromptOpen = open;
+}
+
+bool sim_port_prompt_open()
+{
+  return simPromptOpen;
+}
+
+// Format into buf; false (and logged) if the command does not fit
+static bool sim_port_format(char *buf, size_t size, const char *fmt, va_list args)
+{
+  int len = vsnprintf(buf, size, fmt, args);
+  if (len < 0 || (size_t)len >= size)
+  {
+    atTruncatedCount++;
+    sim_port_logf("!!! AT command too long (%d > %u bytes) - not sent: %.24s...\n", len, (unsigned)(size - 1), buf);
+    return false;
+  }
+  return true;
+}
+
+bool sim_port_sendf(const char *fmt, ...)
+{
+  va_list args;
+  AtTransaction *txn = atTxnPool.acquire();
+  if (txn == nullptr)
+  {
+    // Pool exhausted - format on the stack so the command is never dropped
+    char line[AT_CMD_MAX_LEN];
+    va_start(args, fmt);
+    bool fits = sim_port_format(line, sizeof(line), fmt, args);
+    va_end(args);
+    atFallbackCount++;
+    return fits && sim_port_send(line);
+  }
+
+  va_start(args, fmt);
+  bool fits = sim_port_format(txn->cmd, sizeof(txn->cmd), fmt, args);
+  va_end(args);
+  bool ok = fits && sim_port_send(txn->cmd);
+  atTxnPool.release(txn);
+  return ok;
+}
+
+unsigned long sim_port_millis()
+{
+  return simPort->nowMs();
+}
+
+void sim_port_logf(const char *fmt, ...)
+{
+  char text[SIM_LOG_MAX_LEN];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(text, sizeof(text), fmt, args);
+  va_end(args);
+  simPort->log(text);
+}
+
+void sim_port_feed(char c)
+{
+  if (c == '\r')
+  {
+    return;
+  }
+  if (c == '\n')
+  {
+    // Hand off a copy: handlers may send AT commands, which read (and collect) more bytes
+    bool complete = !simLineOverflow && simLineLen > 0;
+    char line[SIM_LINE_MAX_LEN];
+    memcpy(line, simLineBuf, simLineLen);
+    line[simLineLen] = '\0';
+    simLineLen = 0;
+    simLineOverflow = false;
+    if (complete && simLineHandler != nullptr)
+    {
+      simLineHandler(line);
+    }
+    return;
+  }
+  if (simLineLen < SIM_LINE_MAX_LEN - 1)
+  {
+    simLineBuf[simLineLen++] = c;
+  }
+  else
+  {
+    simLineOverflow = true; // Drop over-long lines (e.g. AT+COPS=? scan results)
+  }
+}
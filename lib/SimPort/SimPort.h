@@ -0,0 +1,63 @@
+/*
+ * Serial link to the SIM module: AT command output and response line input.
+ *
+ * main.cpp binds the port to Serial2 and millis(); the native tests bind it
+ * to a fake module. Plain C++ (no Arduino headers) so it also builds in the
+ * native test environment.
+ */
+
+#ifndef SIM_PORT_H
+#define SIM_PORT_H
+
+#include <stdint.h>
+
+#ifndef SIM_LINE_MAX_LEN
+#define SIM_LINE_MAX_LEN 128 // Longest module response line kept for parsing
+#endif
+
+// Hardware hooks behind the port
+struct SimPort
+{
+  bool (*sendLine)(const char *cmd); // Write one AT command line (CR/LF appended)
+  bool (*sendByte)(char c);          // Write one raw byte (Ctrl+Z ending an SMS)
+  void (*waitMs)(unsigned long ms);  // Blocking delay while the module works
+  unsigned long (*nowMs)();          // Milliseconds since boot
+  void (*log)(const char *text);     // Console output
+};
+
+// Called with every complete response line (without CR/LF)
+typedef void (*SimLineHandler)(const char *line);
+
+extern uint32_t atFallbackCount;  // AT commands sent without a pooled transaction
+extern uint32_t atTruncatedCount; // AT commands refused because they did not fit AT_CMD_MAX_LEN
+
+// Bind the port and the handler for module response lines
+void sim_port_begin(const SimPort *port, SimLineHandler handler);
+
+// Send one AT command line
+bool sim_port_send(const char *cmd);
+
+// Send one raw byte
+bool sim_port_send_byte(char c);
+
+// Block for ms milliseconds
+void sim_port_wait(unsigned long ms);
+
+// Mark an SMS text prompt (after AT+CMGS) as open: AT commands sent meanwhile would become message text
+void sim_port_set_prompt(bool open);
+bool sim_port_prompt_open();
+
+// Format an AT command into a pooled transaction buffer and send it.
+// A command longer than AT_CMD_MAX_LEN is logged and not sent.
+bool sim_port_sendf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Milliseconds since boot from the bound port
+unsigned long sim_port_millis();
+
+// Print a formatted line on the console of the bound port
+void sim_port_logf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Collect one byte from the module into response lines
+void sim_port_feed(char c);
+
+#endif
@@ -0,0 +1,214 @@
+#include "VoiceCall.h"
+
+#include <SimPort.h>
+#include <stdio.h>
+#include <string.h>
+
+bool callInProgress = false;
+bool callAnswered = false;
+unsigned long callStartTime = 0;
+unsigned long callAnsweredTime = 0;
+uint8_t voicePlayCount = 0;
+
+static const VoiceCallEvents *voiceCallEvents = nullptr;
+static bool voicePlayPending = false; // Answered while an SMS prompt was open
+static bool hangUpPending = false;    // Call ended while an SMS prompt was open
+
+void voice_call_begin(const VoiceCallEvents *events)
+{
+  voiceCallEvents = events;
+}
+
+void voice_call_configure_module()
+{
+  sim_port_send("AT+CLCC=1");  // Report call state changes (+CLCC)
+  sim_port_send("AT+DDET=1");  // Report DTMF keys from the callee (+RXDTMF)
+  sim_port_send("AT+CDTAM=1"); // Play TTS / audio files to the remote party
+}
+
+bool voice_call_dial(const char *number)
+{
+  bool ok = sim_port_sendf("ATD%s;", number);
+
+  callInProgress = true;
+  callStartTime = sim_port_millis();
+  callAnswered = false;
+  voicePlayCount = 0;
+  voicePlayPending = false;
+  return ok;
+}
+
+// Start (or replay) the voice message towards the callee
+static void play_voice_alert()
+{
+  if (sim_port_prompt_open())
+  {
+    // AT+CTTS would become SMS text - play once the SMS is sent
+    sim_port_logf("Voice alert deferred until the SMS is sent\n");
+    voicePlayPending = true;
+    return;
+  }
+  voicePlayPending = false;
+  voicePlayCount++;
+  sim_port_logf("Playing voice alert (%u/%u)...\n", voicePlayCount, VOICE_PLAY_REPEATS);
+#if VOICE_ALERT_USE_AUDIO_FILE
+  sim_port_sendf("AT+CCMXPLAY=\"%s\",1,0", VOICE_ALERT_AUDIO_FILE); // play_path 1 = remote party
+#else
+  sim_port_sendf("AT+CTTS=2,\"%s\"", VOICE_ALERT_TTS_TEXT); // 2 = ASCII text
+#endif
+}
+
+// Stop any playback still running
+static void stop_voice_alert()
+{
+#if VOICE_ALERT_USE_AUDIO_FILE
+  sim_port_send("AT+CCMXSTOP");
+#else
+  sim_port_send("AT+CTTS=0");
+#endif
+}
+
+void voice_call_end(const char *reason, bool hangUp)
+{
+  if (!callInProgress)
+  {
+    return;
+  }
+
+  // Settle the state first: the AT commands below read module lines, and a
+  // NO CARRIER / +CLCC arriving meanwhile must find the call already over
+  bool wasAnswered = callAnswered;
+  callInProgress = false;
+  callAnswered = false;
+  voicePlayPending = false;
+  sim_port_logf("Emergency call completed - %s\n", reason);
+  if (voiceCallEvents != nullptr && voiceCallEvents->ended != nullptr)
+  {
+    voiceCallEvents->ended(reason);
+  }
+
+  if (sim_port_prompt_open())
+  {
+    hangUpPending = hangUp; // Sent by voice_call_process() after the SMS
+    return;
+  }
+  if (wasAnswered)
+  {
+    stop_voice_alert();
+  }
+  if (hangUp)
+  {
+    sim_port_send("ATH"); // Hang up
+  }
+}
+
+void voice_call_process()
+{
+  if (sim_port_prompt_open())
+  {
+    return;
+  }
+  if (hangUpPending)
+  {
+    hangUpPending = false;
+    sim_port_send("ATH"); // Hang up
+  }
+  if (voicePlayPending && callInProgress && callAnswered)
+  {
+    play_voice_alert();
+  }
+
+  if (callInProgress)
+  {
+    unsigned long now = sim_port_millis();
+    if (!callAnswered && now - callStartTime >= CALL_DURATION)
+    {
+      voice_call_end("not answered", true);
+    }
+    else if (callAnswered && now - callAnsweredTime >= VOICE_ACK_WINDOW)
+    {
+      voice_call_end("answered, no acknowledgment", true);
+    }
+  }
+}
+
+// Callee picked up: play the message and start the acknowledgment window
+static void on_call_answered()
+{
+  if (!callInProgress || callAnswered)
+  {
+    return;
+  }
+  callAnswered = true;
+  callAnsweredTime = sim_port_millis();
+  voicePlayCount = 0;
+  sim_port_logf("*** CALL ANSWERED - PLAYING VOICE ALERT ***\n");
+  if (voiceCallEvents != nullptr && voiceCallEvents->answered != nullptr)
+  {
+    voiceCallEvents->answered();
+  }
+  play_voice_alert();
+}
+
+// DTMF key received from the callee
+static void on_dtmf_key(char key)
+{
+  sim_port_logf("DTMF key received: %c\n", key);
+  if (!callInProgress || !callAnswered || key != VOICE_ACK_KEY)
+  {
+    return;
+  }
+
+  if (voiceCallEvents != nullptr && voiceCallEvents->acknowledged != nullptr)
+  {
+    voiceCallEvents->acknowledged(key);
+  }
+  voice_call_end("acknowledged", true);
+}
+
+bool voice_call_handle_line(const char *line)
+{
+  if (strcmp(line, "VOICE CALL: BEGIN") == 0)
+  {
+    on_call_answered();
+  }
+  else if (strncmp(line, "VOICE CALL: END", 15) == 0 || strcmp(line, "NO CARRIER") == 0 ||
+           strcmp(line, "BUSY") == 0 || strcmp(line, "NO ANSWER") == 0)
+  {
+    voice_call_end(line, false);
+  }
+  else if (strncmp(line, "+CLCC: ", 7) == 0)
+  {
+    int id = 0;
+    int dir = 0;
+    int stat = 0;
+    if (sscanf(line + 7, "%d,%d,%d", &id, &dir, &stat) == 3 && dir == 0)
+    {
+      if (stat == 0) // Active
+      {
+        on_call_answered();
+      }
+      else if (stat == 6) // Released
+      {
+        voice_call_end("released", false);
+      }
+    }
+  }
+  else if (strncmp(line, "+RXDTMF: ", 9) == 0)
+  {
+    on_dtmf_key(line[9]);
+  }
+  else if (strcmp(line, "+CTTS: 0") == 0 || strncmp(line, "+AUDIOSTATE: audio play stop", 28) == 0)
+  {
+    // Playback finished - replay until acknowledged or repeats are used up
+    if (callInProgress && callAnswered && voicePlayCount < VOICE_PLAY_REPEATS)
+    {
+      play_voice_alert();
+    }
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
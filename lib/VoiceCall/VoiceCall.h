@@ -0,0 +1,68 @@
+/*
+ * Emergency call state machine: dial, play the voice alert when the callee
+ * answers, accept a DTMF acknowledgment and hang up on timeout.
+ *
+ * Driven by module response lines (VOICE CALL / +CLCC / +RXDTMF / +CTTS)
+ * and sends its AT commands through SimPort, so it runs unchanged in the
+ * native test environment.
+ */
+
+#ifndef VOICE_CALL_H
+#define VOICE_CALL_H
+
+#include <stdint.h>
+
+#ifndef VOICE_ALERT_TTS_TEXT
+#define VOICE_ALERT_TTS_TEXT "Power lost at site TAZA. Press 1 to confirm."
+#endif
+#ifndef VOICE_ALERT_USE_AUDIO_FILE
+#define VOICE_ALERT_USE_AUDIO_FILE 0 // 1 = play VOICE_ALERT_AUDIO_FILE instead of TTS
+#endif
+#ifndef VOICE_ALERT_AUDIO_FILE
+#define VOICE_ALERT_AUDIO_FILE "c:/power_lost_taza.amr" // Pre-stored audio on the module file system
+#endif
+#ifndef VOICE_ACK_KEY
+#define VOICE_ACK_KEY '1' // DTMF key that acknowledges the incident
+#endif
+#ifndef VOICE_PLAY_REPEATS
+#define VOICE_PLAY_REPEATS 3 // Times the message is played per answered call
+#endif
+
+const unsigned long CALL_DURATION = 20000;    // Ring time before an unanswered call is dropped
+const unsigned long VOICE_ACK_WINDOW = 30000; // Time to press VOICE_ACK_KEY after answer
+
+// Call progress reported to the application
+struct VoiceCallEvents
+{
+  void (*answered)();                // Callee picked up, voice alert started
+  void (*acknowledged)(char key);    // VOICE_ACK_KEY pressed (call is ended right after)
+  void (*ended)(const char *reason); // Call finished; called before any hang-up command is sent
+};
+
+extern bool callInProgress;
+extern bool callAnswered; // Callee picked up the current call
+extern unsigned long callStartTime;
+extern unsigned long callAnsweredTime;
+extern uint8_t voicePlayCount; // Times the message was started in the current call
+
+// Set the application callbacks (any may be nullptr)
+void voice_call_begin(const VoiceCallEvents *events);
+
+// Enable the call state, DTMF and remote audio settings on the module
+void voice_call_configure_module();
+
+// Dial number and start the ring timeout
+bool voice_call_dial(const char *number);
+
+// Drop the call when it rings or waits for acknowledgment too long; also sends the
+// voice alert / hang-up held back while an SMS prompt was open
+void voice_call_process();
+
+// Finish the current call; hangUp sends ATH (not needed when the network ended it).
+// AT commands are held back while an SMS prompt is open.
+void voice_call_end(const char *reason, bool hangUp);
+
+// Handle a call related response line; false if the line is not about the call
+bool voice_call_handle_line(const char *line);
+
+#endif
@@ -24,6 +24,20 @@
  */
 
 #include <HardwareSerial.h>
+#include <esp_timer.h>
+#include <AlertPool.h> // Fixed pools (sizes default in AlertPool.h, override with -D in build_flags)
+#include <AlertSms.h>  // Alert SMS composition
+#include <SimPort.h>   // Module AT command / response line link
+#include <VoiceCall.h> // Emergency call state machine (voice text and ack key default in VoiceCall.h)
+
+// Set to 1 to spill evicted signal history to the spiffs partition
+#ifndef SIGNAL_LOG_SPIFFS
+#define SIGNAL_LOG_SPIFFS 0
+#endif
+
+#if SIGNAL_LOG_SPIFFS
+#include <SPIFFS.h>
+#endif
 
 // A7683E Module Pin Configuration
 #define simSerial Serial2
@@ -36,6 +50,142 @@
 #define optocoupler_Sensor 19
 
 #define PHONE_NUMBER "+84909483187" // Enter phone number
+#define ALERT_SMS_TEXT "SOS DA MAT DIEN - HAY KIEM TRA THANG MAY TAZA"
+
+// Network time and event journal
+#define NTP_SERVER "pool.ntp.org" // Fallback when the network does not provide NITZ time
+#define JOURNAL_SIZE 32           // Events kept in RAM
+#define JOURNAL_TEXT_LEN 56       // Longest event text
+#define TIMESTAMP_LEN 32          // "2026-10-19T15:15:02.123+07:00"
+
+// Memory report interval
+const unsigned long MEMORY_REPORT_INTERVAL = 300000; // Print memory report every 5 minutes
+
+uint32_t heapAfterSetup = 0; // Free heap at end of setup() - baseline for drift
+
+// Signal quality / registration history
+#define SIGNAL_LOG_BYTES 6144        // Ring buffer size (~2-3 bytes per steady-state sample)
+#define SIGNAL_RECORD_MAX_BYTES 24   // Longest encoded record (all fields changed)
+#define SIGNAL_ANCHOR_MAX_BYTES 8    // Longest spill file UTC anchor record
+#define SIGNAL_DUMP_LINES_PER_LOOP 8 // CSV lines printed per loop() pass (~25 ms at 115200 baud)
+#define SIGNAL_SPILL_BUF_BYTES 256   // Evicted bytes batched per SPIFFS write
+#define SIGNAL_SPILL_MAX_PERCENT 35  // Spill file share of SPIFFS before rotating to .old (.bin + .old < 100%)
+#define SIGNAL_SPILL_PATH "/signal.bin"
+#define SIGNAL_SPILL_OLD_PATH "/signal.old"
+
+const unsigned long SIGNAL_SAMPLE_INTERVAL = 120000;  // Sample CSQ/CREG/COPS every 2 minutes
+const unsigned long AT_QUERY_GAP = 300;              // Gap between background AT queries
+const unsigned long SIGNAL_REPORT_INTERVAL = 3600000; // Print signal rollup every hour
+const uint32_t SIGNAL_ROLLUP_WINDOW = 3600;           // Rollup window for periodic report (seconds)
+
+// Record header bits (low 3 bits hold the CREG registration state)
+#define SIG_REG_MASK 0x07
+#define SIG_NET_PIN 0x08
+#define SIG_RSSI_CHANGED 0x10
+#define SIG_BER_CHANGED 0x20
+#define SIG_CELL_CHANGED 0x40
+#define SIG_ANCHOR 0x80 // Spill files only: UTC anchor (varint UTC seconds at the previous t, tz byte)
+
+// One sample of network state
+struct SignalSample
+{
+  uint32_t t;        // Seconds since boot
+  uint8_t rssi;      // AT+CSQ rssi (0-31, 99 = unknown)
+  uint8_t ber;       // AT+CSQ ber (0-7, 99 = unknown)
+  uint8_t regStat;   // AT+CREG stat (0-5, 7 = unknown)
+  uint8_t netPin;    // NET pin level
+  uint16_t lac;      // Location area code
+  uint32_t cellId;   // Serving cell ID
+  uint32_t operCode; // Numeric operator (MCC+MNC), 0 = unknown
+};
+
+const SignalSample SIGNAL_SAMPLE_UNKNOWN = {0, 99, 99, 7, 0, 0, 0, 0};
+
+// Latest values parsed from module responses
+SignalSample latestSignal = SIGNAL_SAMPLE_UNKNOWN;
+bool signalSamplePending = false; // Periodic query sent, commit on +CREG response
+unsigned long lastSignalSampleMillis = 0;
+uint32_t signalUptimeSec = 0;     // Wrap-free seconds counter for sample timestamps
+
+// Delta/varint encoded ring buffer: records from tail to head, each relative
+// to the previous one; signalLogBase is the state before the oldest record
+uint8_t signalLog[SIGNAL_LOG_BYTES];
+uint16_t signalLogHead = 0;
+uint16_t signalLogTail = 0;
+uint16_t signalLogUsed = 0;
+uint16_t signalLogCount = 0;
+uint32_t signalLogEvicted = 0;
+SignalSample signalLogBase = SIGNAL_SAMPLE_UNKNOWN;
+SignalSample signalLogLast = SIGNAL_SAMPLE_UNKNOWN;
+
+// Console dump in progress, printed SIGNAL_DUMP_LINES_PER_LOOP lines per loop() pass
+struct SignalDumpState
+{
+  bool active;
+  SignalSample cur;  // Last decoded sample
+  uint16_t offset;   // Next record (ring offset, or offset in window for spill files)
+  uint32_t nextSeq;  // RAM dump: sequence number of the next record (evicted + index)
+  uint32_t endSeq;   // RAM dump: stop before this sequence number
+#if SIGNAL_LOG_SPIFFS
+  File file;         // Spill file being dumped (closed for RAM dumps)
+  uint8_t fileIndex; // 0 = .old next, 1 = current next, 2 = done
+  bool skipHeader;   // First record of a file is its base state
+  uint8_t window[128];
+  uint16_t windowLen;
+  bool anchored;       // File has given a UTC anchor so far
+  uint32_t anchorT;    // Sample time (t_s) of the anchor
+  uint32_t anchorUtc;  // UTC seconds at anchorT
+  int8_t anchorTz;     // Time zone in 15 minute steps
+#endif
+};
+
+SignalDumpState signalDump;
+
+#if SIGNAL_LOG_SPIFFS
+uint8_t signalSpillBuf[SIGNAL_SPILL_BUF_BYTES];
+uint16_t signalSpillLen = 0;
+bool signalSpillStarted = false; // Spill file has its starting record
+bool signalSpillAnchored = false; // UTC anchor written since the file started / the clock last synced
+bool signalSpillReady = false;   // SPIFFS mounted
+size_t signalSpillMaxBytes = 0;  // Rotation size, from SPIFFS.totalBytes()
+#endif
+
+// Network clock: UTC = anchorUtc + elapsed monotonic time, corrected by drift
+const unsigned long CLOCK_SYNC_INTERVAL = 3600000;            // Re-read network time every hour
+const unsigned long CLOCK_RETRY_INTERVAL = 60000;             // Retry every minute until synced
+const unsigned long CLOCK_NTP_STEP_GAP = 2000;                // Gap between NTP fallback commands
+const int64_t CLOCK_DRIFT_MIN_SPAN_US = 6LL * 3600 * 1000000; // Drift needs a 6 h baseline (CCLK has 1 s resolution)
+const int64_t CLOCK_STEP_LIMIT_US = 10000000;                 // Errors above 10 s re-anchor instead of correcting
+const int32_t CLOCK_MAX_DRIFT_PPB = 500000;                   // Clamp drift to +/-500 ppm
+const uint8_t CLOCK_NTP_AFTER_INVALID = 3;                    // Unset RTC readings before falling back to NTP
+
+bool clockSynced = false;
+int64_t clockAnchorMonoUs = 0; // Monotonic time of the mapping anchor
+int64_t clockAnchorUtcUs = 0;  // UTC (us since 1970) at the anchor
+int64_t clockBaseMonoUs = 0;   // First sync of the drift baseline
+int64_t clockBaseUtcUs = 0;
+int32_t clockDriftPpb = 0;     // Local clock error, parts per billion (+ = local clock slow)
+int64_t clockLastErrorUs = 0;  // Mapping error measured at the last sync
+int8_t clockTzQuarters = 0;    // Local time zone from +CCLK, in 15 minute steps
+uint32_t clockSyncCount = 0;
+bool clockQueryDue = false;    // Send AT+CCLK? at the next idle slot
+bool clockNtpPending = false;  // Network time invalid - run the NTP fallback
+uint8_t clockInvalidReads = 0; // Consecutive +CCLK readings with an unset RTC
+int64_t clockQuerySentUs = 0;  // When AT+CCLK? was sent (0 = no reading expected)
+unsigned long lastIdleQueryTime = 0; // Last background AT query (signal sampling / clock sync)
+unsigned long idleQueryGap = 0;      // Quiet time required after that query
+
+// Timestamped event journal (monotonic time, mapped to UTC when printed)
+struct JournalEntry
+{
+  int64_t monoUs;
+  char text[JOURNAL_TEXT_LEN];
+};
+
+JournalEntry journal[JOURNAL_SIZE];
+uint8_t journalHead = 0;
+uint8_t journalCount = 0;
+uint32_t journalTotal = 0;
 
 // Variables to track previous sensor state
 bool lastSensorState = false;
@@ -54,20 +204,20 @@ const unsigned long CALL_COOLDOWN_PERIOD = 60000; // 1 minute cooldown between b
 unsigned long lastSensorReadTime = 0;
 unsigned long lastAtWaitTime = 0;
 unsigned long smsStartTime = 0;
-unsigned long callStartTime = 0;
 bool smsInProgress = false;
-bool callInProgress = false;
 bool moduleInitialized = false;
 
 // Timer intervals
 const unsigned long SENSOR_READ_INTERVAL = 100; // Read sensor every 100ms (faster response)
 const unsigned long AT_WAIT_INTERVAL = 100;     // AT wait interval
 const unsigned long SMS_TIMEOUT = 10000;        // SMS timeout 10 seconds
-const unsigned long CALL_DURATION = 20000;      // Call duration 20 seconds
+
+// Voice alert / acknowledgment state
+bool incidentAcknowledged = false; // DTMF ack received - no more SMS/calls until power is restored
 
 // Function declarations (C++ requires forward declarations)
 void sim_at_wait();
-bool sim_at_cmd(String cmd);
+bool sim_at_cmd(const char *cmd);
 bool sim_at_send(char c);
 void init_a7683e_module();
 bool check_network_status_pin();
@@ -79,15 +229,61 @@ void monitor_net_status();
 void diagnostic_sim();
 bool check_network_status();
 void reconnect_network();
-void sent_sms(String message);
+void sent_sms(const char *message);
 void call();
 void readSensor();
-void start_emergency_sms();
+bool start_emergency_sms();
 void start_emergency_call();
 void handle_sms_process();
-void handle_call_process();
 void non_blocking_sim_at_wait();
 void check_call_cooldown();
+void print_memory_report();
+void report_memory_periodic();
+void sim_process_byte(char c);
+void handle_sim_line(const char *line);
+void sample_signal_periodic();
+void signal_log_append(const SignalSample &sample);
+void start_signal_dump();
+void start_signal_spill_dump();
+void continue_signal_dump();
+void end_signal_dump(const char *reason);
+void print_signal_rollup(uint32_t windowSec);
+void report_signal_periodic();
+void init_signal_log_storage();
+void on_call_answered();
+void on_call_acknowledged(char key);
+void on_call_ended(const char *reason);
+int64_t days_from_civil(int y, int m, int d);
+int64_t clock_mono_to_utc_us(int64_t monoUs);
+void format_timestamp(int64_t monoUs, char *out, size_t len);
+void format_local_time(int64_t utcMs, int8_t tzQuarters, char *out, size_t len);
+void print_report_time();
+void clock_apply_network_time(int64_t utcUs, int64_t monoUs, int8_t tzQuarters);
+void sync_clock_periodic();
+bool idle_query_slot_free();
+void idle_query_sent(unsigned long gap);
+void journal_log(const char *fmt, ...);
+void print_journal();
+void print_clock_status();
+
+// Module serial link and call events for the SimPort / VoiceCall libraries
+unsigned long sim_port_now()
+{
+  return millis();
+}
+
+void sim_port_delay(unsigned long ms)
+{
+  delay(ms);
+}
+
+void sim_port_print(const char *text)
+{
+  Serial.print(text);
+}
+
+const SimPort simPortSerial = {sim_at_cmd, sim_at_send, sim_port_delay, sim_port_now, sim_port_print};
+const VoiceCallEvents callEvents = {on_call_answered, on_call_acknowledged, on_call_ended};
 
 void readSensor()
 {
@@ -102,15 +298,15 @@ void readSensor()
     if (millis() - lastDebugTime >= 10000)
     {
       Serial.println("=== SENSOR DEBUG ===");
-      Serial.println("Digital reading: " + String(valueOpto));
-      Serial.println("Last state: " + String(lastSensorState));
+      Serial.printf("Digital reading: %u\n", valueOpto);
+      Serial.printf("Last state: %d\n", lastSensorState);
       Serial.println("===================");
       lastDebugTime = millis();
     }
     else
     {
       // Normal reading display
-      Serial.println("Opto: " + String(valueOpto) + " (0=Power ON, 1=Power OFF)");
+      Serial.printf("Opto: %u (0=Power ON, 1=Power OFF)\n", valueOpto);
     }
 
     // Check for power loss (sensor = 1) and state change
@@ -118,27 +314,35 @@ void readSensor()
     {
       // ALWAYS notify immediately when power loss is first detected
       Serial.println("*** POWER LOSS DETECTED! ***");
+      journal_log("Power loss detected");
       Serial.println("Transition: Power ON -> Power OFF");
       Serial.println("Starting emergency notification sequence...");
 
-      // Start SMS notification (non-blocking)
-      start_emergency_sms();
+      // New incident - previous acknowledgment no longer applies
+      incidentAcknowledged = false;
 
-      lastNotificationTime = millis();
+      // Start SMS notification (non-blocking)
+      if (start_emergency_sms())
+      {
+        lastNotificationTime = millis();
+      }
     }
     // Check for repeated power loss notifications (every 5 seconds while power is still lost)
     else if (valueOpto == 1 && lastSensorState == true)
     {
-      // Only send repeated notifications if 5 seconds have passed
-      if (millis() - lastNotificationTime > NOTIFICATION_INTERVAL)
+      // Only send repeated notifications if 5 seconds have passed, nobody acknowledged
+      // and no SMS or call is in progress (the call owns currentAlert and the module)
+      if (!incidentAcknowledged && !smsInProgress && !callInProgress &&
+          millis() - lastNotificationTime > NOTIFICATION_INTERVAL)
       {
         Serial.println("*** POWER STILL LOST - REPEAT NOTIFICATION ***");
         Serial.println("Sending repeated emergency notification...");
 
         // Start SMS notification (non-blocking)
-        start_emergency_sms();
-
-        lastNotificationTime = millis();
+        if (start_emergency_sms())
+        {
+          lastNotificationTime = millis();
+        }
       }
     }
 
@@ -146,7 +350,9 @@ void readSensor()
     else if (valueOpto == 0 && lastSensorState == true)
     {
       Serial.println("*** POWER RESTORED! ***");
+      journal_log("Power restored");
       Serial.println("Transition: Power OFF -> Power ON");
+      incidentAcknowledged = false;
     }
 
     // Update previous sensor state
@@ -160,7 +366,7 @@ void sim_at_wait()
   // Non-blocking version - just read available data
   while (simSerial.available())
   {
-    Serial.write(simSerial.read());
+    sim_process_byte(simSerial.read());
   }
 }
 
@@ -171,13 +377,13 @@ void non_blocking_sim_at_wait()
   {
     while (simSerial.available())
     {
-      Serial.write(simSerial.read());
+      sim_process_byte(simSerial.read());
     }
     lastAtWaitTime = millis();
   }
 }
 
-bool sim_at_cmd(String cmd)
+bool sim_at_cmd(const char *cmd)
 {
   simSerial.println(cmd);
   sim_at_wait();
@@ -268,6 +474,7 @@ void monitor_net_status()
     {
       Serial.print("NET Status changed: ");
       Serial.println(current_net_status ? "CONNECTED" : "DISCONNECTED");
+      journal_log("NET pin %s", current_net_status ? "HIGH" : "LOW");
       last_net_status = current_net_status;
     }
 
@@ -384,42 +591,31 @@ void reconnect_network()
   check_network_status();
 }
 
-// Non-blocking emergency SMS starter
-void start_emergency_sms()
+// Non-blocking emergency SMS starter; false if an SMS or call is still in progress
+bool start_emergency_sms()
 {
-  if (!smsInProgress)
+  if (smsInProgress || callInProgress)
   {
-    Serial.println("=== STARTING EMERGENCY SMS ===");
-    wakeup_module();
-
-    // Step 1: Set SMS text mode
-    Serial.println("1. Setting SMS text mode...");
-    sim_at_cmd("AT+CMGF=1"); // Text mode
-    delay(1000);             // Wait for command to be processed
-
-    // Step 2: Set phone number
-    Serial.println("2. Setting recipient number...");
-    String temp = "AT+CMGS=\"";
-    temp += PHONE_NUMBER;
-    temp += "\"";
-    sim_at_cmd(temp);
-    delay(2000); // Wait longer for prompt
-
-    // Step 3: Send message content
-    Serial.println("3. Sending message content...");
-    Serial.println("Content: SOS DA MAT DIEN - HAY KIEM TRA THANG MAY TAZA");
-    sim_at_cmd("SOS DA MAT DIEN - HAY KIEM TRA THANG MAY TAZA");
-    delay(1000); // Wait before sending end character
+    return false;
+  }
 
-    // Step 4: End message with Ctrl+Z
-    Serial.println("4. Ending message...");
-    sim_at_send(0x1A); // End message
-    delay(500);        // Final delay
+  Serial.println("=== STARTING EMERGENCY SMS ===");
+  wakeup_module();
 
-    smsInProgress = true;
-    smsStartTime = millis();
-    Serial.println("=== EMERGENCY SMS PROCESS STARTED ===");
+  // Alert SMS stamped with its start time (pooled buffer, static text if pools are exhausted)
+  int64_t monoUs = esp_timer_get_time();
+  char stamp[TIMESTAMP_LEN];
+  format_timestamp(monoUs, stamp, sizeof(stamp));
+  if (!alert_sms_start(PHONE_NUMBER, ALERT_SMS_TEXT, stamp, monoUs))
+  {
+    return false;
   }
+
+  smsInProgress = true;
+  smsStartTime = millis();
+  journal_log("SMS sent, alert #%lu", currentAlert ? (unsigned long)currentAlert->id : 0UL);
+  Serial.println("=== EMERGENCY SMS PROCESS STARTED ===");
+  return true;
 }
 
 // Non-blocking emergency call starter with call limiting
@@ -441,7 +637,7 @@ void start_emergency_call()
       {
         // Still in cooldown, skip this call
         unsigned long remainingCooldown = CALL_COOLDOWN_PERIOD - (millis() - callCooldownStartTime);
-        Serial.println("*** CALL COOLDOWN ACTIVE - " + String(remainingCooldown / 1000) + " seconds remaining ***");
+        Serial.printf("*** CALL COOLDOWN ACTIVE - %lu seconds remaining ***\n", remainingCooldown / 1000);
         return;
       }
     }
@@ -452,22 +648,17 @@ void start_emergency_call()
       // Start cooldown period
       inCallCooldown = true;
       callCooldownStartTime = millis();
-      Serial.println("*** MAX CALLS REACHED (" + String(MAX_CALLS_PER_BATCH) + ") - STARTING 1 MINUTE COOLDOWN ***");
+      Serial.printf("*** MAX CALLS REACHED (%d) - STARTING 1 MINUTE COOLDOWN ***\n", MAX_CALLS_PER_BATCH);
       return;
     }
 
     // Make the call
     wakeup_module();
-    String temp = "ATD";
-    temp += PHONE_NUMBER;
-    temp += ";";
-    sim_at_cmd(temp); // Make call
-
-    callInProgress = true;
-    callStartTime = millis();
+    voice_call_dial(PHONE_NUMBER); // Make call
     callCount++;
 
-    Serial.println("*** EMERGENCY CALL " + String(callCount) + "/" + String(MAX_CALLS_PER_BATCH) + " INITIATED ***");
+    Serial.printf("*** EMERGENCY CALL %d/%d INITIATED ***\n", callCount, MAX_CALLS_PER_BATCH);
+    journal_log("Call %d/%d dialed", callCount, MAX_CALLS_PER_BATCH);
 
     // If this is the first call of a new batch, record batch start time
     if (callCount == 1)
@@ -487,53 +678,64 @@ void handle_sms_process()
       smsInProgress = false;
       Serial.println("SMS process completed/timeout");
 
-      // Start emergency call after SMS
-      start_emergency_call();
+      // Start emergency call after SMS unless the incident was acknowledged meanwhile
+      if (!incidentAcknowledged)
+      {
+        start_emergency_call();
+      }
+
+      // Alert is finished if no call was placed (cooldown / call limit)
+      if (!callInProgress)
+      {
+        alert_finish();
+      }
     }
   }
 }
 
-// Handle call process with timeout
-void handle_call_process()
+// Callee picked up (VoiceCall has started the voice alert)
+void on_call_answered()
+{
+  journal_log("Call answered");
+}
+
+// Callee pressed VOICE_ACK_KEY (VoiceCall ends the call next)
+void on_call_acknowledged(char key)
 {
-  if (callInProgress)
+  if (currentAlert != nullptr)
   {
-    if (millis() - callStartTime >= CALL_DURATION)
-    {
-      sim_at_cmd("ATH"); // Hang up
-      callInProgress = false;
-      Serial.println("Emergency call completed - hung up");
-    }
+    Serial.printf("*** ALERT #%lu ACKNOWLEDGED after %lu s ***\n", (unsigned long)currentAlert->id,
+                  (millis() - currentAlert->startTime) / 1000);
+    journal_log("Alert #%lu acknowledged (DTMF %c)", (unsigned long)currentAlert->id, key);
   }
+  else
+  {
+    Serial.println("*** CALL ACKNOWLEDGED ***");
+  }
+
+  // Only a power-loss incident is suppressed; a test call just ends
+  if (lastSensorState)
+  {
+    incidentAcknowledged = true;
+    Serial.println("No further SMS/calls until power is restored");
+  }
+}
+
+// Call finished: release its alert (before VoiceCall sends the hang-up commands)
+void on_call_ended(const char *reason)
+{
+  journal_log("Call ended: %s", reason);
+  alert_finish();
 }
 
 // Legacy blocking functions for manual testing
-void sent_sms(String message)
+void sent_sms(const char *message)
 {
   // Ensure module is awake
   wakeup_module();
 
   Serial.println("=== SENDING TEST SMS ===");
-  Serial.println("1. Setting SMS text mode...");
-  sim_at_cmd("AT+CMGF=1"); // Text mode
-  delay(1000);             // Wait for command to be processed
-
-  Serial.println("2. Setting recipient number...");
-  String temp = "AT+CMGS=\"";
-  temp += PHONE_NUMBER;
-  temp += "\"";
-  sim_at_cmd(temp);
-  delay(2000); // Wait for prompt
-
-  Serial.println("3. Sending message content...");
-  Serial.println("Content: " + message);
-  sim_at_cmd(message); // Message content
-  delay(1000);         // Wait before ending
-
-  Serial.println("4. Ending message...");
-  // End message
-  sim_at_send(0x1A);
-  delay(500);
+  alert_sms_send(PHONE_NUMBER, message);
 
   Serial.println("=== TEST SMS COMPLETED ===");
 }
@@ -543,14 +745,8 @@ void call()
   // Ensure module is awake
   wakeup_module();
 
-  String temp = "ATD";
-  temp += PHONE_NUMBER;
-  temp += ";";
-  sim_at_cmd(temp); // Make call
-
-  // Non-blocking call - will be managed by handle_call_process()
-  callInProgress = true;
-  callStartTime = millis();
+  // Non-blocking call - will be managed by voice_call_process()
+  voice_call_dial(PHONE_NUMBER); // Make call
 }
 
 // Check call cooldown status (for monitoring)
@@ -563,12 +759,989 @@ void check_call_cooldown()
     unsigned long remainingCooldown = CALL_COOLDOWN_PERIOD - (millis() - callCooldownStartTime);
     if (remainingCooldown > 0)
     {
-      Serial.println(">>> Call cooldown: " + String(remainingCooldown / 1000) + " seconds remaining");
+      Serial.printf(">>> Call cooldown: %lu seconds remaining\n", remainingCooldown / 1000);
       lastCooldownReport = millis();
     }
   }
 }
 
+// Print one pool's allocation counters
+template <typename T, uint8_t N>
+void print_pool_stats(const FixedPool<T, N> &pool)
+{
+  Serial.printf("  %-8s in use %u/%u, peak %u, acquired %lu, released %lu, failures %lu\n", pool.name, pool.inUse,
+                pool.capacity(), pool.peak, (unsigned long)pool.acquired, (unsigned long)pool.released,
+                (unsigned long)pool.failures);
+}
+
+// Print heap and pool statistics
+void print_memory_report()
+{
+  uint32_t freeHeap = ESP.getFreeHeap();
+
+  Serial.println("=== MEMORY REPORT ===");
+  print_report_time();
+  Serial.printf("Uptime: %lu s\n", millis() / 1000);
+  Serial.printf("Free heap: %lu bytes (of %lu)\n", (unsigned long)freeHeap, (unsigned long)ESP.getHeapSize());
+  Serial.printf("Largest free block: %lu bytes\n", (unsigned long)ESP.getMaxAllocHeap());
+  Serial.printf("Min free heap ever: %lu bytes\n", (unsigned long)ESP.getMinFreeHeap());
+  Serial.printf("Heap drift since setup: %ld bytes\n", (long)heapAfterSetup - (long)freeHeap);
+  Serial.println("Pools:");
+  print_pool_stats(alertPool);
+  print_pool_stats(atTxnPool);
+  print_pool_stats(msgBufferPool);
+  Serial.printf("AT commands sent without pool: %lu\n", (unsigned long)atFallbackCount);
+  Serial.printf("AT commands refused (too long): %lu\n", (unsigned long)atTruncatedCount);
+  Serial.println("=====================");
+}
+
+// Print the memory report every MEMORY_REPORT_INTERVAL
+void report_memory_periodic()
+{
+  static unsigned long lastMemoryReport = 0;
+
+  if (millis() - lastMemoryReport >= MEMORY_REPORT_INTERVAL)
+  {
+    print_memory_report();
+    lastMemoryReport = millis();
+  }
+}
+
+// Echo a module byte to the console and collect it into response lines
+void sim_process_byte(char c)
+{
+  Serial.write(c);
+  sim_port_feed(c);
+}
+
+// Parse one comma-separated field: decimal, or hex when quoted ("1A2B")
+static const char *parse_field(const char *p, uint32_t *value)
+{
+  if (*p == '"')
+  {
+    *value = strtoul(p + 1, nullptr, 16);
+  }
+  else
+  {
+    *value = strtoul(p, nullptr, 10);
+  }
+  const char *comma = strchr(p, ',');
+  return comma ? comma + 1 : nullptr;
+}
+
+// Update latestSignal from +CSQ / +CREG / +COPS responses
+void handle_sim_line(const char *line)
+{
+  // Voice call progress
+  if (voice_call_handle_line(line))
+  {
+    return;
+  }
+
+  if (strncmp(line, "+CCLK: ", 7) == 0)
+  {
+    // "yy/MM/dd,hh:mm:ss+zz" - local time, zz in quarter hours
+    int64_t monoUs = esp_timer_get_time();
+    int64_t sentUs = clockQuerySentUs;
+    clockQuerySentUs = 0;
+    int yy, mo, dd, hh, mi, ss, tz;
+    if (sentUs == 0)
+    {
+      // Not our query (typed on the console) - leave the clock alone
+    }
+    else if (monoUs - sentUs > (int64_t)AT_QUERY_GAP * 1000)
+    {
+      // Held up behind other traffic: the RTC reading no longer matches monoUs
+      Serial.println("Late +CCLK reading discarded");
+      clockQueryDue = true;
+    }
+    else if (sscanf(line + 7, "\"%d/%d/%d,%d:%d:%d%d\"", &yy, &mo, &dd, &hh, &mi, &ss, &tz) == 7)
+    {
+      if (yy < 24 || yy >= 70) // Module RTC never set (defaults to 1970/01/01 or 1980/01/06)
+      {
+        // Give NITZ a few retries after registration before falling back to NTP
+        if (!clockSynced && ++clockInvalidReads >= CLOCK_NTP_AFTER_INVALID)
+        {
+          Serial.println("Network time not available - using NTP fallback");
+          clockNtpPending = true;
+          clockInvalidReads = 0;
+        }
+      }
+      else
+      {
+        int64_t localSec = days_from_civil(2000 + yy, mo, dd) * 86400LL + hh * 3600LL + mi * 60LL + ss;
+        int64_t utcUs = (localSec - tz * 900LL) * 1000000LL + 500000; // Mid-second: CCLK truncates
+        clock_apply_network_time(utcUs, monoUs, tz);
+      }
+    }
+  }
+  else if (strncmp(line, "+CNTP: ", 7) == 0)
+  {
+    int err = atoi(line + 7);
+    if (err == 0)
+    {
+      clockQueryDue = true; // RTC updated - read it back
+    }
+    else
+    {
+      journal_log("NTP sync failed (%d)", err);
+    }
+  }
+  else if (strncmp(line, "+CSQ: ", 6) == 0)
+  {
+    int rssi = 99;
+    int ber = 99;
+    if (sscanf(line + 6, "%d,%d", &rssi, &ber) == 2)
+    {
+      latestSignal.rssi = rssi;
+      latestSignal.ber = ber;
+    }
+  }
+  else if (strncmp(line, "+CREG: ", 7) == 0)
+  {
+    // Query response: n,stat[,lac,ci]  -  URC: stat[,lac,ci]
+    uint32_t fields[4];
+    uint8_t count = 0;
+    const char *p = line + 7;
+    while (p != nullptr && count < 4)
+    {
+      p = parse_field(p, &fields[count++]);
+    }
+    uint8_t first = (count % 2 == 0) ? 1 : 0; // Even field count = query response
+    if (count > first)
+    {
+      latestSignal.regStat = fields[first] & SIG_REG_MASK;
+    }
+    if (count >= first + 3)
+    {
+      latestSignal.lac = fields[first + 1];
+      latestSignal.cellId = fields[first + 2];
+    }
+
+    // +CREG? is the last query of a periodic sample
+    if (signalSamplePending && first == 1)
+    {
+      unsigned long now = millis();
+      uint32_t elapsed = (now - lastSignalSampleMillis) / 1000;
+      signalUptimeSec += elapsed;
+      lastSignalSampleMillis += elapsed * 1000UL;
+
+      latestSignal.t = signalUptimeSec;
+      latestSignal.netPin = digitalRead(MCU_SIM_NET_PIN);
+      signal_log_append(latestSignal);
+      signalSamplePending = false;
+    }
+  }
+  else if (strncmp(line, "+COPS: ", 7) == 0)
+  {
+    // mode[,format,"oper"[,act]] - operator is numeric after AT+COPS=3,2
+    int mode = 0;
+    int format = 0;
+    unsigned long oper = 0;
+    if (sscanf(line + 7, "%d,%d,\"%lu\"", &mode, &format, &oper) == 3 && format == 2)
+    {
+      latestSignal.operCode = oper;
+    }
+    else if (sscanf(line + 7, "%d", &mode) == 1)
+    {
+      latestSignal.operCode = 0; // Not registered on any operator
+    }
+  }
+}
+
+// Query CSQ / COPS / CREG every SIGNAL_SAMPLE_INTERVAL while the modem is idle.
+// One command per AT_QUERY_GAP so each gets its response before the next.
+void sample_signal_periodic()
+{
+  static const char *const queries[] = {"AT+CSQ", "AT+COPS?", "AT+CREG?"}; // +CREG commits the sample
+  static unsigned long lastSignalQuery = 0;
+  static uint8_t queryStep = 0;
+
+  if (!moduleInitialized || smsInProgress || callInProgress)
+  {
+    queryStep = 0;
+    return;
+  }
+  if (!idle_query_slot_free()) // Shared with clock sync
+  {
+    return;
+  }
+  if (queryStep == 0)
+  {
+    if (millis() - lastSignalQuery < SIGNAL_SAMPLE_INTERVAL)
+    {
+      return;
+    }
+    lastSignalQuery = millis();
+  }
+
+  if (queryStep == 2)
+  {
+    signalSamplePending = true;
+  }
+  sim_at_cmd(queries[queryStep]);
+  idle_query_sent(AT_QUERY_GAP);
+  queryStep = (queryStep + 1) % 3;
+}
+
+static uint8_t put_varint(uint8_t *out, uint32_t value)
+{
+  uint8_t len = 0;
+  while (value >= 0x80)
+  {
+    out[len++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  out[len++] = value;
+  return len;
+}
+
+static uint32_t get_varint(const uint8_t *buf, uint16_t size, uint16_t *offset)
+{
+  uint32_t value = 0;
+  uint8_t shift = 0;
+  uint8_t b;
+  do
+  {
+    b = buf[(*offset)++ % size];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while ((b & 0x80) && shift < 35);
+  return value;
+}
+
+// Encode a sample relative to prev: dt, header, [zigzag rssi delta], [ber], [lac, cell, oper]
+static uint8_t signal_encode(const SignalSample &prev, const SignalSample &cur, uint8_t *out)
+{
+  uint8_t header = (cur.regStat & SIG_REG_MASK) | (cur.netPin ? SIG_NET_PIN : 0);
+  if (cur.rssi != prev.rssi)
+  {
+    header |= SIG_RSSI_CHANGED;
+  }
+  if (cur.ber != prev.ber)
+  {
+    header |= SIG_BER_CHANGED;
+  }
+  if (cur.lac != prev.lac || cur.cellId != prev.cellId || cur.operCode != prev.operCode)
+  {
+    header |= SIG_CELL_CHANGED;
+  }
+
+  uint8_t len = put_varint(out, cur.t - prev.t);
+  out[len++] = header;
+  if (header & SIG_RSSI_CHANGED)
+  {
+    int32_t delta = (int32_t)cur.rssi - (int32_t)prev.rssi;
+    len += put_varint(out + len, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+  }
+  if (header & SIG_BER_CHANGED)
+  {
+    out[len++] = cur.ber;
+  }
+  if (header & SIG_CELL_CHANGED)
+  {
+    len += put_varint(out + len, cur.lac);
+    len += put_varint(out + len, cur.cellId);
+    len += put_varint(out + len, cur.operCode);
+  }
+  return len;
+}
+
+// Decode the record at offset in buf (wrapping at size) relative to prev; returns the record length
+static uint16_t signal_decode(const uint8_t *buf, uint16_t size, uint16_t offset, const SignalSample &prev,
+                              SignalSample *out)
+{
+  uint16_t p = offset;
+  *out = prev;
+  out->t = prev.t + get_varint(buf, size, &p);
+  uint8_t header = buf[p++ % size];
+  out->regStat = header & SIG_REG_MASK;
+  out->netPin = (header & SIG_NET_PIN) ? 1 : 0;
+  if (header & SIG_RSSI_CHANGED)
+  {
+    uint32_t zz = get_varint(buf, size, &p);
+    int32_t delta = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+    out->rssi = prev.rssi + delta;
+  }
+  if (header & SIG_BER_CHANGED)
+  {
+    out->ber = buf[p++ % size];
+  }
+  if (header & SIG_CELL_CHANGED)
+  {
+    out->lac = get_varint(buf, size, &p);
+    out->cellId = get_varint(buf, size, &p);
+    out->operCode = get_varint(buf, size, &p);
+  }
+  return p - offset;
+}
+
+#if SIGNAL_LOG_SPIFFS
+// Write batched evicted records to the spill file, rotating it when full
+// Move the spill file to .old; the next record starts a new file with its base state
+static void signal_spill_rotate()
+{
+  SPIFFS.remove(SIGNAL_SPILL_OLD_PATH);
+  SPIFFS.rename(SIGNAL_SPILL_PATH, SIGNAL_SPILL_OLD_PATH);
+  signalSpillStarted = false;
+  signalSpillAnchored = false;
+}
+
+static void signal_spill_flush()
+{
+  if (!signalSpillReady || signalSpillLen == 0 || signalDump.file)
+  {
+    return; // Nothing to write, or a console dump is reading the file
+  }
+  File f = SPIFFS.open(SIGNAL_SPILL_PATH, FILE_APPEND);
+  size_t written = 0;
+  size_t size = 0;
+  if (f)
+  {
+    written = f.write(signalSpillBuf, signalSpillLen);
+    size = f.size();
+    f.close();
+  }
+
+  if (written != signalSpillLen)
+  {
+    // Records only decode against the one before, so a lost batch would corrupt the rest of
+    // the file: drop it and continue in a new file (rotating also frees space when SPIFFS is full)
+    journal_log("Signal spill write failed (%u/%u bytes) - new file", (unsigned)written, signalSpillLen);
+    signal_spill_rotate();
+  }
+  else if (size >= signalSpillMaxBytes)
+  {
+    signal_spill_rotate();
+  }
+  signalSpillLen = 0;
+}
+
+// Anchor record: maps signalLogBase.t (the sample before the next record) to UTC
+static uint8_t signal_encode_anchor(uint8_t *out)
+{
+  int64_t utcUs = clock_mono_to_utc_us((int64_t)signalLogBase.t * 1000000);
+  uint8_t n = put_varint(out, 0); // dt
+  out[n++] = SIG_ANCHOR;
+  n += put_varint(out + n, (uint32_t)(utcUs / 1000000));
+  out[n++] = (uint8_t)clockTzQuarters;
+  return n;
+}
+
+// Queue one evicted record; a new spill file first gets the absolute state the record builds on,
+// and a UTC anchor once the clock is synced
+static void signal_spill_record(const uint8_t *record, uint8_t len)
+{
+  uint8_t needed = len + (signalSpillStarted ? 0 : SIGNAL_RECORD_MAX_BYTES);
+  needed += (clockSynced && !signalSpillAnchored) ? SIGNAL_ANCHOR_MAX_BYTES : 0;
+  if (signalSpillLen + needed > SIGNAL_SPILL_BUF_BYTES)
+  {
+    if (signalDump.file)
+    {
+      end_signal_dump("aborted - spill buffer full");
+    }
+    signal_spill_flush(); // May rotate the file and clear signalSpillStarted
+  }
+  if (!signalSpillStarted)
+  {
+    signalSpillLen += signal_encode(SIGNAL_SAMPLE_UNKNOWN, signalLogBase, signalSpillBuf + signalSpillLen);
+    signalSpillStarted = true;
+  }
+  if (clockSynced && !signalSpillAnchored)
+  {
+    signalSpillLen += signal_encode_anchor(signalSpillBuf + signalSpillLen);
+    signalSpillAnchored = true;
+  }
+  memcpy(signalSpillBuf + signalSpillLen, record, len);
+  signalSpillLen += len;
+}
+#endif
+
+// Drop the oldest record, folding it into signalLogBase
+static void signal_log_evict_oldest()
+{
+  SignalSample oldest;
+  uint16_t len = signal_decode(signalLog, SIGNAL_LOG_BYTES, signalLogTail, signalLogBase, &oldest);
+
+#if SIGNAL_LOG_SPIFFS
+  if (signalSpillReady)
+  {
+    uint8_t record[SIGNAL_RECORD_MAX_BYTES];
+    for (uint16_t i = 0; i < len; i++)
+    {
+      record[i] = signalLog[(signalLogTail + i) % SIGNAL_LOG_BYTES];
+    }
+    signal_spill_record(record, len);
+  }
+#endif
+
+  signalLogBase = oldest;
+  signalLogTail = (signalLogTail + len) % SIGNAL_LOG_BYTES;
+  signalLogUsed -= len;
+  signalLogCount--;
+  signalLogEvicted++;
+}
+
+// Append a sample, evicting the oldest records when the ring is full
+void signal_log_append(const SignalSample &sample)
+{
+  uint8_t record[SIGNAL_RECORD_MAX_BYTES];
+  uint8_t len = signal_encode(signalLogLast, sample, record);
+
+  while (signalLogUsed + len > SIGNAL_LOG_BYTES)
+  {
+    signal_log_evict_oldest();
+  }
+  for (uint8_t i = 0; i < len; i++)
+  {
+    signalLog[signalLogHead] = record[i];
+    signalLogHead = (signalLogHead + 1) % SIGNAL_LOG_BYTES;
+  }
+  signalLogUsed += len;
+  signalLogCount++;
+  signalLogLast = sample;
+}
+
+static void print_signal_sample(const SignalSample &sample, const char *time)
+{
+  Serial.printf("%lu,%s,%u,%u,%u,%u,%X,%lX,%lu\n", (unsigned long)sample.t, time, sample.rssi, sample.ber,
+                sample.regStat, sample.netPin, sample.lac, (unsigned long)sample.cellId, (unsigned long)sample.operCode);
+}
+
+// Start dumping the RAM series as CSV; loop() prints it a few lines at a time
+void start_signal_dump()
+{
+  end_signal_dump("restarted");
+  Serial.println("=== SIGNAL HISTORY ===");
+  print_report_time();
+  Serial.printf("Uptime: %lu s (t_s is uptime, time is empty until the clock syncs)\n", millis() / 1000);
+  Serial.printf("%u samples, %u/%u bytes, %lu evicted\n", signalLogCount, signalLogUsed, SIGNAL_LOG_BYTES,
+                (unsigned long)signalLogEvicted);
+  Serial.println("t_s,time,rssi,ber,reg,net,lac,cell,oper");
+
+  signalDump.active = true;
+  signalDump.cur = signalLogBase;
+  signalDump.offset = signalLogTail;
+  signalDump.nextSeq = signalLogEvicted;
+  signalDump.endSeq = signalLogEvicted + signalLogCount; // Samples added meanwhile are not chased
+}
+
+// Stop a running dump (no-op when idle)
+void end_signal_dump(const char *reason)
+{
+  if (!signalDump.active)
+  {
+    return;
+  }
+#if SIGNAL_LOG_SPIFFS
+  if (signalDump.file)
+  {
+    signalDump.file.close();
+  }
+#endif
+  signalDump.active = false;
+  Serial.printf("=== SIGNAL DUMP %s ===\n", reason);
+}
+
+#if SIGNAL_LOG_SPIFFS
+// Open the next spill file to dump (.old first); false when none is left
+static bool open_next_spill_file()
+{
+  while (signalDump.fileIndex < 2)
+  {
+    const char *path = signalDump.fileIndex++ == 0 ? SIGNAL_SPILL_OLD_PATH : SIGNAL_SPILL_PATH;
+    if (!SPIFFS.exists(path))
+    {
+      continue;
+    }
+    signalDump.file = SPIFFS.open(path, FILE_READ);
+    if (signalDump.file)
+    {
+      Serial.printf("# %s (%lu bytes, t_s is uptime of the boot that wrote it, time from its UTC anchors)\n",
+                    path, (unsigned long)signalDump.file.size());
+      signalDump.windowLen = 0;
+      signalDump.anchored = false;
+      signalDump.offset = 0;
+      signalDump.skipHeader = true;
+      signalDump.cur = SIGNAL_SAMPLE_UNKNOWN;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Start dumping the spilled history from SPIFFS
+void start_signal_spill_dump()
+{
+  end_signal_dump("restarted");
+  if (!signalSpillReady)
+  {
+    Serial.println("SPIFFS not mounted - no spilled signal history");
+    return;
+  }
+  signal_spill_flush(); // Queued records go to the file before it is read
+  Serial.println("=== SPILLED SIGNAL HISTORY ===");
+  Serial.println("t_s,time,rssi,ber,reg,net,lac,cell,oper");
+  signalDump.active = true;
+  signalDump.fileIndex = 0;
+  if (!open_next_spill_file())
+  {
+    end_signal_dump("done - no spill files");
+  }
+}
+
+// Print up to SIGNAL_DUMP_LINES_PER_LOOP samples from the open spill file
+static void continue_signal_spill_dump()
+{
+  for (uint8_t lines = 0; lines < SIGNAL_DUMP_LINES_PER_LOOP;)
+  {
+    // Keep at least one whole record in the window
+    if (signalDump.windowLen - signalDump.offset < SIGNAL_RECORD_MAX_BYTES && signalDump.file.available())
+    {
+      uint16_t left = signalDump.windowLen - signalDump.offset;
+      memmove(signalDump.window, signalDump.window + signalDump.offset, left);
+      signalDump.windowLen = left + signalDump.file.read(signalDump.window + left, sizeof(signalDump.window) - left);
+      signalDump.offset = 0;
+    }
+    if (signalDump.offset >= signalDump.windowLen)
+    {
+      signalDump.file.close();
+      if (!open_next_spill_file())
+      {
+        end_signal_dump("done");
+      }
+      return;
+    }
+
+    uint16_t p = signalDump.offset;
+    get_varint(signalDump.window, sizeof(signalDump.window), &p);
+    if (signalDump.window[p % sizeof(signalDump.window)] & SIG_ANCHOR)
+    {
+      p++;
+      uint32_t utc = get_varint(signalDump.window, sizeof(signalDump.window), &p);
+      int8_t tz = (int8_t)signalDump.window[p++ % sizeof(signalDump.window)];
+      if (p > signalDump.windowLen)
+      {
+        signalDump.offset = signalDump.windowLen; // Partial last record
+        continue;
+      }
+      signalDump.offset = p;
+      signalDump.anchored = true;
+      signalDump.anchorT = signalDump.cur.t;
+      signalDump.anchorUtc = utc;
+      signalDump.anchorTz = tz;
+      continue;
+    }
+
+    SignalSample next;
+    uint16_t len = signal_decode(signalDump.window, sizeof(signalDump.window), signalDump.offset, signalDump.cur,
+                                 &next);
+    if (signalDump.offset + len > signalDump.windowLen)
+    {
+      signalDump.offset = signalDump.windowLen; // Partial last record (write cut short by a full SPIFFS)
+      continue;
+    }
+    signalDump.offset += len;
+    signalDump.cur = next;
+    if (signalDump.skipHeader)
+    {
+      signalDump.skipHeader = false; // Base state, already the last sample of the previous file
+      continue;
+    }
+
+    char time[TIMESTAMP_LEN] = "";
+    if (signalDump.anchored)
+    {
+      int64_t utcSec = (int64_t)signalDump.anchorUtc + ((int64_t)next.t - signalDump.anchorT);
+      format_local_time(utcSec * 1000, signalDump.anchorTz, time, sizeof(time));
+    }
+    print_signal_sample(next, time);
+    lines++;
+  }
+}
+#endif
+
+// Print the next few lines of a running dump; called from loop()
+void continue_signal_dump()
+{
+  if (!signalDump.active)
+  {
+    return;
+  }
+#if SIGNAL_LOG_SPIFFS
+  if (signalDump.file)
+  {
+    continue_signal_spill_dump();
+    return;
+  }
+#endif
+
+  // Records evicted since the dump started are gone - resume at the current oldest one
+  if (signalDump.nextSeq < signalLogEvicted)
+  {
+    Serial.printf("# %lu samples evicted during dump\n", (unsigned long)(signalLogEvicted - signalDump.nextSeq));
+    signalDump.cur = signalLogBase;
+    signalDump.offset = signalLogTail;
+    signalDump.nextSeq = signalLogEvicted;
+  }
+
+  for (uint8_t lines = 0; lines < SIGNAL_DUMP_LINES_PER_LOOP && signalDump.nextSeq < signalDump.endSeq; lines++)
+  {
+    SignalSample next;
+    signalDump.offset = (signalDump.offset + signal_decode(signalLog, SIGNAL_LOG_BYTES, signalDump.offset,
+                                                            signalDump.cur, &next)) %
+                        SIGNAL_LOG_BYTES;
+    signalDump.cur = next;
+    signalDump.nextSeq++;
+
+    char time[TIMESTAMP_LEN] = "";
+    if (clockSynced)
+    {
+      format_timestamp((int64_t)next.t * 1000000, time, sizeof(time));
+    }
+    print_signal_sample(next, time);
+  }
+
+  if (signalDump.nextSeq >= signalDump.endSeq)
+  {
+    end_signal_dump("done");
+    print_signal_rollup(0);
+  }
+}
+
+// Print min/avg/max RSSI and registration ratio over the last windowSec (0 = whole history)
+void print_signal_rollup(uint32_t windowSec)
+{
+  uint32_t from = (windowSec == 0 || signalLogLast.t < windowSec) ? 0 : signalLogLast.t - windowSec;
+  uint16_t samples = 0;
+  uint16_t rssiSamples = 0;
+  uint16_t registered = 0;
+  uint16_t netHigh = 0;
+  uint8_t rssiMin = 31;
+  uint8_t rssiMax = 0;
+  uint32_t rssiSum = 0;
+
+  SignalSample cur = signalLogBase;
+  uint16_t offset = signalLogTail;
+  for (uint16_t i = 0; i < signalLogCount; i++)
+  {
+    SignalSample next;
+    offset += signal_decode(signalLog, SIGNAL_LOG_BYTES, offset, cur, &next);
+    cur = next;
+    if (cur.t < from)
+    {
+      continue;
+    }
+    samples++;
+    if (cur.regStat == 1 || cur.regStat == 5) // Home or roaming
+    {
+      registered++;
+    }
+    if (cur.netPin)
+    {
+      netHigh++;
+    }
+    if (cur.rssi <= 31)
+    {
+      rssiSamples++;
+      rssiSum += cur.rssi;
+      rssiMin = cur.rssi < rssiMin ? cur.rssi : rssiMin;
+      rssiMax = cur.rssi > rssiMax ? cur.rssi : rssiMax;
+    }
+  }
+
+  if (windowSec == 0)
+  {
+    Serial.println("=== SIGNAL ROLLUP (all) ===");
+  }
+  else
+  {
+    Serial.printf("=== SIGNAL ROLLUP (last %lu s) ===\n", (unsigned long)windowSec);
+  }
+  print_report_time();
+  Serial.printf("Samples: %u\n", samples);
+  if (rssiSamples > 0)
+  {
+    // dBm = -113 + 2 * rssi
+    Serial.printf("RSSI min/avg/max: %d/%d/%d dBm\n", -113 + 2 * rssiMin,
+                  -113 + (int)(2 * rssiSum / rssiSamples), -113 + 2 * rssiMax);
+  }
+  else
+  {
+    Serial.println("RSSI min/avg/max: no valid readings");
+  }
+  if (samples > 0)
+  {
+    Serial.printf("Registered: %u%%, NET pin high: %u%%\n", registered * 100U / samples, netHigh * 100U / samples);
+  }
+  Serial.println("===========================");
+}
+
+// Print the signal rollup every SIGNAL_REPORT_INTERVAL
+void report_signal_periodic()
+{
+  static unsigned long lastSignalReport = 0;
+
+  if (millis() - lastSignalReport >= SIGNAL_REPORT_INTERVAL)
+  {
+#if SIGNAL_LOG_SPIFFS
+    signal_spill_flush();
+#endif
+    print_signal_rollup(SIGNAL_ROLLUP_WINDOW);
+    lastSignalReport = millis();
+  }
+}
+
+// Mount SPIFFS for spilled history; the previous boot's file becomes .old
+void init_signal_log_storage()
+{
+#if SIGNAL_LOG_SPIFFS
+  if (!SPIFFS.begin(true))
+  {
+    Serial.println("SPIFFS mount failed - signal history kept in RAM only");
+    return;
+  }
+  if (SPIFFS.exists(SIGNAL_SPILL_PATH))
+  {
+    signal_spill_rotate();
+  }
+  signalSpillMaxBytes = SPIFFS.totalBytes() * SIGNAL_SPILL_MAX_PERCENT / 100;
+  signalSpillReady = true;
+#endif
+}
+
+// Background AT queries (signal sampling, clock sync) share one slot so they never overlap
+bool idle_query_slot_free()
+{
+  return millis() - lastIdleQueryTime >= idleQueryGap;
+}
+
+void idle_query_sent(unsigned long gap)
+{
+  lastIdleQueryTime = millis();
+  idleQueryGap = gap;
+}
+
+// Days since 1970-01-01 for a Gregorian calendar date
+int64_t days_from_civil(int y, int m, int d)
+{
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Gregorian calendar date for days since 1970-01-01
+static void civil_from_days(int64_t z, int *y, int *m, int *d)
+{
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int doe = z - era * 146097;
+  int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = yoe + era * 400 + (*m <= 2);
+}
+
+// Map esp_timer_get_time() to UTC microseconds (0 until the first sync) - no AT round trip
+int64_t clock_mono_to_utc_us(int64_t monoUs)
+{
+  if (!clockSynced)
+  {
+    return 0;
+  }
+  int64_t elapsed = monoUs - clockAnchorMonoUs;
+  return clockAnchorUtcUs + elapsed + (elapsed / 1000) * clockDriftPpb / 1000000;
+}
+
+// Local time with offset ("2026-10-19T15:15:02.123+07:00"), or uptime before the first sync
+void format_timestamp(int64_t monoUs, char *out, size_t len)
+{
+  if (!clockSynced)
+  {
+    snprintf(out, len, "up %lu.%03lus", (unsigned long)(monoUs / 1000000), (unsigned long)(monoUs / 1000 % 1000));
+    return;
+  }
+
+  format_local_time(clock_mono_to_utc_us(monoUs) / 1000, clockTzQuarters, out, len);
+}
+
+// Local time with offset for UTC milliseconds and a time zone in 15 minute steps
+void format_local_time(int64_t utcMs, int8_t tzQuarters, char *out, size_t len)
+{
+  int64_t localMs = utcMs + tzQuarters * 900000LL;
+  int64_t localSec = localMs / 1000;
+  int secOfDay = localSec % 86400;
+  int y, m, d;
+  civil_from_days(localSec / 86400, &y, &m, &d);
+
+  int tzAbs = tzQuarters < 0 ? -tzQuarters : tzQuarters;
+  snprintf(out, len, "%04d-%02d-%02dT%02d:%02d:%02d.%03d%c%02d:%02d", y, m, d, secOfDay / 3600, secOfDay / 60 % 60,
+           secOfDay % 60, (int)(localMs % 1000), tzQuarters < 0 ? '-' : '+', tzAbs / 4, tzAbs % 4 * 15);
+}
+
+// Print the "Time:" line that heads each console report
+void print_report_time()
+{
+  char stamp[TIMESTAMP_LEN];
+  format_timestamp(esp_timer_get_time(), stamp, sizeof(stamp));
+  Serial.printf("Time: %s\n", stamp);
+}
+
+// Fold a network time reading (taken at monoUs) into the monotonic -> UTC mapping
+void clock_apply_network_time(int64_t utcUs, int64_t monoUs, int8_t tzQuarters)
+{
+  clockTzQuarters = tzQuarters;
+  clockSyncCount++;
+  clockInvalidReads = 0;
+#if SIGNAL_LOG_SPIFFS
+  signalSpillAnchored = false; // Next spilled record carries the corrected mapping
+#endif
+
+  if (!clockSynced)
+  {
+    clockSynced = true;
+    clockAnchorMonoUs = clockBaseMonoUs = monoUs;
+    clockAnchorUtcUs = clockBaseUtcUs = utcUs;
+    clockLastErrorUs = 0;
+    journal_log("Clock synced to network time"); // Earlier entries now map to UTC too
+    return;
+  }
+
+  int64_t predicted = clock_mono_to_utc_us(monoUs);
+  int64_t error = utcUs - predicted;
+  clockLastErrorUs = error;
+
+  if (error > CLOCK_STEP_LIMIT_US || error < -CLOCK_STEP_LIMIT_US)
+  {
+    // Network time jumped (operator correction, NTP after bad NITZ) - restart the drift baseline
+    clockAnchorMonoUs = clockBaseMonoUs = monoUs;
+    clockAnchorUtcUs = clockBaseUtcUs = utcUs;
+    journal_log("Clock stepped by %ld s", (long)(error / 1000000)); // Over 10 s, so seconds fit a 32-bit long
+    return;
+  }
+
+  // Drift over the whole baseline, so CCLK's 1 s resolution averages out
+  int64_t span = monoUs - clockBaseMonoUs;
+  if (span >= CLOCK_DRIFT_MIN_SPAN_US)
+  {
+    int64_t ppb = ((utcUs - clockBaseUtcUs) - span) * 1000000LL / (span / 1000);
+    if (ppb > CLOCK_MAX_DRIFT_PPB)
+    {
+      ppb = CLOCK_MAX_DRIFT_PPB;
+    }
+    else if (ppb < -CLOCK_MAX_DRIFT_PPB)
+    {
+      ppb = -CLOCK_MAX_DRIFT_PPB;
+    }
+    clockDriftPpb = ppb;
+  }
+
+  // Move the anchor half way to the reading to smooth out single-reading jitter
+  clockAnchorMonoUs = monoUs;
+  clockAnchorUtcUs = predicted + error / 2;
+}
+
+// Read AT+CCLK? hourly (every minute until synced); run the NTP fallback when needed
+void sync_clock_periodic()
+{
+  static const char *const ntpCommands[] = {"AT+CGACT=1,1", "AT+CNTP=\"" NTP_SERVER "\",0", "AT+CNTP"};
+  static unsigned long lastClockQuery = 0;
+  static uint8_t ntpStep = 0;
+
+  if (!moduleInitialized || smsInProgress || callInProgress)
+  {
+    ntpStep = 0;
+    return;
+  }
+  if (!idle_query_slot_free())
+  {
+    return;
+  }
+
+  if (clockNtpPending)
+  {
+    // Activate the data bearer, set the server, then sync; +CNTP: 0 triggers the read-back
+    sim_at_cmd(ntpCommands[ntpStep]);
+    idle_query_sent(CLOCK_NTP_STEP_GAP);
+    if (++ntpStep == 3)
+    {
+      ntpStep = 0;
+      clockNtpPending = false;
+    }
+    return;
+  }
+
+  unsigned long interval = clockSynced ? CLOCK_SYNC_INTERVAL : CLOCK_RETRY_INTERVAL;
+  if (clockQueryDue || millis() - lastClockQuery >= interval)
+  {
+    clockQuerySentUs = esp_timer_get_time(); // Before sending: the reply may be read inside sim_at_cmd()
+    sim_at_cmd("AT+CCLK?");
+    idle_query_sent(AT_QUERY_GAP);
+    clockQueryDue = false;
+    lastClockQuery = millis();
+  }
+}
+
+// Record an event with its monotonic time and echo it to the console
+void journal_log(const char *fmt, ...)
+{
+  JournalEntry *entry = &journal[journalHead];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(entry->text, JOURNAL_TEXT_LEN, fmt, args);
+  va_end(args);
+  entry->monoUs = esp_timer_get_time();
+
+  journalHead = (journalHead + 1) % JOURNAL_SIZE;
+  if (journalCount < JOURNAL_SIZE)
+  {
+    journalCount++;
+  }
+  journalTotal++;
+
+  char stamp[TIMESTAMP_LEN];
+  format_timestamp(entry->monoUs, stamp, sizeof(stamp));
+  Serial.printf("[%s] %s\n", stamp, entry->text);
+}
+
+// Print journal entries, oldest first
+void print_journal()
+{
+  Serial.printf("=== EVENT JOURNAL (last %u of %lu) ===\n", journalCount, (unsigned long)journalTotal);
+  for (uint8_t i = 0; i < journalCount; i++)
+  {
+    const JournalEntry &entry = journal[(journalHead + JOURNAL_SIZE - journalCount + i) % JOURNAL_SIZE];
+    char stamp[TIMESTAMP_LEN];
+    format_timestamp(entry.monoUs, stamp, sizeof(stamp));
+    Serial.printf("%s  %s\n", stamp, entry.text);
+  }
+  Serial.println("=====================================");
+}
+
+// Print network clock state
+void print_clock_status()
+{
+  Serial.println("=== CLOCK ===");
+  print_report_time();
+  Serial.printf("Synced: %s (%lu syncs)\n", clockSynced ? "YES" : "NO", (unsigned long)clockSyncCount);
+  Serial.printf("Drift: %ld ppb\n", (long)clockDriftPpb);
+  if (clockLastErrorUs > CLOCK_STEP_LIMIT_US || clockLastErrorUs < -CLOCK_STEP_LIMIT_US)
+  {
+    // A step can exceed what a 32-bit long holds in ms
+    Serial.printf("Last sync error: %ld s (stepped)\n", (long)(clockLastErrorUs / 1000000));
+  }
+  else
+  {
+    Serial.printf("Last sync error: %ld ms\n", (long)(clockLastErrorUs / 1000));
+  }
+  Serial.println("=============");
+}
+
 void setup()
 {
   Serial.begin(115200);
@@ -579,6 +1752,10 @@ void setup()
   lastSensorReadTime = millis();
   lastAtWaitTime = millis();
 
+  // Module line handling and call state machine
+  sim_port_begin(&simPortSerial, handle_sim_line);
+  voice_call_begin(&callEvents);
+
   // Initialize A7683E module
   init_a7683e_module();
 
@@ -593,12 +1770,12 @@ void setup()
   for (int i = 0; i < 10; i++)
   {
     int reading = digitalRead(optocoupler_Sensor);
-    Serial.println("Reading " + String(i + 1) + ": " + String(reading));
+    Serial.printf("Reading %d: %d\n", i + 1, reading);
     delay(100);
   }
 
   lastSensorState = digitalRead(optocoupler_Sensor);
-  Serial.println("Final initial sensor state: " + String(lastSensorState));
+  Serial.printf("Final initial sensor state: %d\n", lastSensorState);
   Serial.println("Optocoupler Logic: 0=Power ON, 1=Power OFF/Lost");
   Serial.println("==============================");
 
@@ -617,7 +1794,15 @@ void setup()
   sim_at_cmd("AT+CPIN?"); // Check SIM slot
   sim_at_cmd("AT+CSQ");   // Check signal quality
   sim_at_cmd("AT+CIMI");  // Get IMSI
+  sim_at_cmd("AT+CREG=2");   // Report LAC / cell ID in +CREG
+  sim_at_cmd("AT+COPS=3,2"); // Numeric operator format for +COPS?
+  voice_call_configure_module(); // +CLCC / +RXDTMF reports, voice alert to the remote party
+  sim_at_cmd("AT+CTZU=1");   // Update module RTC from network time (NITZ)
+  clockQueryDue = true;      // First AT+CCLK? as soon as the modem is idle
   moduleInitialized = true;
+  signalUptimeSec = millis() / 1000; // t_s counts from boot, like the journal's "up" stamps
+  lastSignalSampleMillis = signalUptimeSec * 1000UL;
+  init_signal_log_storage();
   Serial.println("Module communication initialized SUCCESSFULLY!");
 
   Serial.println("Monitoring power loss sensor...");
@@ -626,7 +1811,16 @@ void setup()
   Serial.println("Press '2' to test call");
   Serial.println("Press '3' to check module status");
   Serial.println("Press '4' to test optocoupler diagnostics");
+  Serial.println("Press '5' to show memory report");
+  Serial.println("Press '6' to dump signal history");
+  Serial.println("Press '7' to show event journal and clock");
+#if SIGNAL_LOG_SPIFFS
+  Serial.println("Press '8' to dump spilled signal history");
+#endif
   Serial.println("===================================");
+
+  // Baseline for heap drift reporting
+  heapAfterSetup = ESP.getFreeHeap();
 }
 
 void loop()
@@ -638,11 +1832,22 @@ void loop()
   handle_sms_process();
 
   // Handle ongoing call process
-  handle_call_process();
+  voice_call_process();
 
   // Check call cooldown status
   check_call_cooldown();
 
+  // Periodic heap / pool report
+  report_memory_periodic();
+
+  // Periodic signal / registration sampling and hourly rollup
+  sample_signal_periodic();
+  report_signal_periodic();
+  continue_signal_dump();
+
+  // Network time sync (AT+CCLK?, NTP fallback)
+  sync_clock_periodic();
+
   // Handle test commands from Serial Monitor
   if (Serial.available())
   {
@@ -678,22 +1883,27 @@ void loop()
 
     case '3':
       Serial.println("=== Module Status ===");
-      Serial.println("SMS in progress: " + String(smsInProgress ? "YES" : "NO"));
-      Serial.println("Call in progress: " + String(callInProgress ? "YES" : "NO"));
-      Serial.println("Last sensor state: " + String(lastSensorState));
-      Serial.println("Call count in batch: " + String(callCount) + "/" + String(MAX_CALLS_PER_BATCH));
-      Serial.println("In call cooldown: " + String(inCallCooldown ? "YES" : "NO"));
+      Serial.printf("SMS in progress: %s\n", smsInProgress ? "YES" : "NO");
+      Serial.printf("Call in progress: %s\n", callInProgress ? "YES" : "NO");
+      Serial.printf("Last sensor state: %d\n", lastSensorState);
+      Serial.printf("Call count in batch: %d/%d\n", callCount, MAX_CALLS_PER_BATCH);
+      Serial.printf("In call cooldown: %s\n", inCallCooldown ? "YES" : "NO");
+      Serial.printf("Call answered: %s\n", callAnswered ? "YES" : "NO");
+      Serial.printf("Incident acknowledged: %s\n", incidentAcknowledged ? "YES" : "NO");
       if (inCallCooldown)
       {
         unsigned long remainingCooldown = CALL_COOLDOWN_PERIOD - (millis() - callCooldownStartTime);
-        Serial.println("Cooldown remaining: " + String(remainingCooldown / 1000) + " seconds");
+        Serial.printf("Cooldown remaining: %lu seconds\n", remainingCooldown / 1000);
       }
+      Serial.printf("Last signal: rssi %u, ber %u, reg %u, lac %X, cell %lX, oper %lu\n", latestSignal.rssi,
+                    latestSignal.ber, latestSignal.regStat, latestSignal.lac, (unsigned long)latestSignal.cellId,
+                    (unsigned long)latestSignal.operCode);
       check_network_status_pin();
       break;
 
     case '4':
       Serial.println("=== OPTOCOUPLER DIAGNOSTICS ===");
-      Serial.println("GPIO Pin: " + String(optocoupler_Sensor));
+      Serial.printf("GPIO Pin: %d\n", optocoupler_Sensor);
 
       // Test different configurations
       Serial.println("\n1. Testing INPUT mode:");
@@ -701,7 +1911,7 @@ void loop()
       delay(10);
       for (int i = 0; i < 5; i++)
       {
-        Serial.println("  Reading " + String(i + 1) + ": " + String(digitalRead(optocoupler_Sensor)));
+        Serial.printf("  Reading %d: %d\n", i + 1, digitalRead(optocoupler_Sensor));
         delay(200);
       }
 
@@ -710,7 +1920,7 @@ void loop()
       delay(10);
       for (int i = 0; i < 5; i++)
       {
-        Serial.println("  Reading " + String(i + 1) + ": " + String(digitalRead(optocoupler_Sensor)));
+        Serial.printf("  Reading %d: %d\n", i + 1, digitalRead(optocoupler_Sensor));
         delay(200);
       }
 
@@ -719,7 +1929,7 @@ void loop()
       delay(10);
       for (int i = 0; i < 5; i++)
       {
-        Serial.println("  Reading " + String(i + 1) + ": " + String(digitalRead(optocoupler_Sensor)));
+        Serial.printf("  Reading %d: %d\n", i + 1, digitalRead(optocoupler_Sensor));
         delay(200);
       }
 
@@ -729,6 +1939,25 @@ void loop()
       Serial.println("================================");
       break;
 
+    case '5':
+      print_memory_report();
+      break;
+
+    case '6':
+      start_signal_dump(); // Rollup follows when the dump completes
+      break;
+
+    case '7':
+      print_clock_status();
+      print_journal();
+      break;
+
+#if SIGNAL_LOG_SPIFFS
+    case '8':
+      start_signal_spill_dump();
+      break;
+#endif
+
     default:
       // Forward other AT commands to SIM module if needed
       if (command != '\n' && command != '\r')
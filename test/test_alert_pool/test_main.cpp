@@ -0,0 +1,264 @@
+/*
+ * Soak test for the alert pools: steady-state alert cycles, run through the
+ * same AlertSms / VoiceCall code as the firmware, must not touch the heap
+ * and must leave every pool empty.
+ *
+ * Run with: pio test -e native
+ */
+
+#include <stdlib.h> // Before the hooks: defines __GLIBC__
+
+#include <AlertPool.h>
+#include <AlertSms.h>
+#include <SimPort.h>
+#include <VoiceCall.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define SOAK_CYCLES 100000
+#define TEST_NUMBER "+84909483187"
+#define TEST_SMS_TEXT "SOS DA MAT DIEN - HAY KIEM TRA THANG MAY TAZA"
+#define TEST_STAMP "2026-10-19T15:15:02.123+07:00"
+
+// Count heap allocations made anywhere in the process
+static unsigned long heapAllocations = 0;
+
+#if defined(__GLIBC__)
+// Interpose the C allocator: catches malloc from libc, libstdc++ and the code under test
+#define HEAP_HOOKED 1
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+extern "C" void *malloc(size_t size)
+{
+  heapAllocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+  heapAllocations++;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+  heapAllocations++;
+  return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p)
+{
+  __libc_free(p);
+}
+#else
+#define HEAP_HOOKED 0 // Other C libraries: only operator new is counted
+#endif
+
+void *operator new(size_t size)
+{
+#if !HEAP_HOOKED
+  heapAllocations++;
+#endif
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+// Fake module: remembers the SMS text, answers ATH with NO CARRIER
+static char lastSmsText[MSG_MAX_LEN];
+static bool expectSmsText = false;
+static uint32_t linesSent = 0;
+static unsigned long fakeNow = 0;
+
+static bool fake_send_line(const char *cmd)
+{
+  linesSent++;
+  if (expectSmsText)
+  {
+    snprintf(lastSmsText, sizeof(lastSmsText), "%s", cmd);
+    expectSmsText = false;
+  }
+  if (strncmp(cmd, "AT+CMGS=", 8) == 0)
+  {
+    expectSmsText = true; // Next line is the message body
+  }
+  return true;
+}
+
+static bool fake_send_byte(char c)
+{
+  (void)c;
+  return true;
+}
+
+static void fake_wait_ms(unsigned long ms)
+{
+  fakeNow += ms;
+}
+
+static unsigned long fake_now_ms()
+{
+  return fakeNow;
+}
+
+static void fake_log(const char *text)
+{
+  (void)text;
+}
+
+static void fake_line_handler(const char *line)
+{
+  voice_call_handle_line(line);
+}
+
+// Same release point as main.cpp's on_call_ended()
+static void on_ended(const char *reason)
+{
+  (void)reason;
+  alert_finish();
+}
+
+static const SimPort fakePort = {fake_send_line, fake_send_byte, fake_wait_ms, fake_now_ms, fake_log};
+static const VoiceCallEvents events = {nullptr, nullptr, on_ended};
+
+static void feed(const char *text)
+{
+  for (const char *p = text; *p != '\0'; p++)
+  {
+    sim_port_feed(*p);
+  }
+  sim_port_feed('\r');
+  sim_port_feed('\n');
+}
+
+void setUp()
+{
+  sim_port_begin(&fakePort, fake_line_handler);
+  voice_call_begin(&events);
+}
+
+void tearDown()
+{
+}
+
+// One alert as main.cpp runs it: SMS -> call -> callee hangs up -> release
+static void run_alert_cycle(uint32_t cycle)
+{
+  TEST_ASSERT_TRUE(alert_sms_start(TEST_NUMBER, TEST_SMS_TEXT, TEST_STAMP, (int64_t)cycle * 1000000));
+  TEST_ASSERT_NOT_NULL(currentAlert);
+  TEST_ASSERT_NOT_NULL(currentAlert->message);
+
+  voice_call_dial(TEST_NUMBER);
+  fakeNow += 5000;
+  feed("NO CARRIER");
+  TEST_ASSERT_NULL(currentAlert);
+}
+
+template <typename T, uint8_t N>
+static void assert_pool_drained(const FixedPool<T, N> &pool)
+{
+  TEST_ASSERT_EQUAL_UINT8(0, pool.inUse);
+  TEST_ASSERT_EQUAL_UINT32(pool.acquired, pool.released);
+  TEST_ASSERT_EQUAL_UINT32(0, pool.failures);
+}
+
+void test_alert_cycles_keep_heap_flat()
+{
+  run_alert_cycle(0); // Warm-up: first use of stdio may allocate its buffers
+  TEST_ASSERT_EQUAL_STRING(TEST_SMS_TEXT " (" TEST_STAMP ")", lastSmsText);
+
+  unsigned long allocationsBefore = heapAllocations;
+  uint32_t alertsBefore = alertPool.acquired;
+  uint32_t fallbacksBefore = atFallbackCount;
+
+  for (uint32_t i = 1; i <= SOAK_CYCLES; i++)
+  {
+    run_alert_cycle(i);
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(0, heapAllocations - allocationsBefore);
+  TEST_ASSERT_EQUAL_UINT32(SOAK_CYCLES, alertPool.acquired - alertsBefore);
+  TEST_ASSERT_EQUAL_UINT32(fallbacksBefore, atFallbackCount);
+  assert_pool_drained(alertPool);
+  assert_pool_drained(atTxnPool);
+  assert_pool_drained(msgBufferPool);
+  TEST_ASSERT_EQUAL_UINT8(1, alertPool.peak);
+#if !HEAP_HOOKED
+  TEST_MESSAGE("malloc not hooked on this C library - only operator new was counted");
+#endif
+}
+
+void test_heap_hook_counts_malloc()
+{
+  unsigned long allocationsBefore = heapAllocations;
+  void *volatile p = malloc(16);
+  free(p);
+  TEST_ASSERT_EQUAL_UINT32(HEAP_HOOKED ? 1 : 0, heapAllocations - allocationsBefore);
+}
+
+void test_exhausted_pool_fails_without_leaking()
+{
+  Alert *held[ALERT_POOL_SIZE];
+  for (uint8_t i = 0; i < ALERT_POOL_SIZE; i++)
+  {
+    held[i] = alert_pool_acquire();
+    TEST_ASSERT_NOT_NULL(held[i]);
+  }
+
+  // SMS still goes out with the static text
+  uint32_t failuresBefore = alertPool.failures;
+  TEST_ASSERT_TRUE(alert_sms_start(TEST_NUMBER, TEST_SMS_TEXT, TEST_STAMP, 0));
+  TEST_ASSERT_NULL(currentAlert);
+  TEST_ASSERT_EQUAL_UINT32(failuresBefore + 1, alertPool.failures);
+  TEST_ASSERT_EQUAL_STRING(TEST_SMS_TEXT, lastSmsText);
+  alert_finish();
+
+  for (uint8_t i = 0; i < ALERT_POOL_SIZE; i++)
+  {
+    alert_pool_release(held[i]);
+  }
+  alert_pool_release(held[0]); // Double release is ignored
+
+  TEST_ASSERT_EQUAL_UINT8(0, alertPool.inUse);
+  TEST_ASSERT_EQUAL_UINT8(0, msgBufferPool.inUse);
+  TEST_ASSERT_EQUAL_UINT32(alertPool.acquired, alertPool.released);
+  TEST_ASSERT_EQUAL_UINT32(msgBufferPool.acquired, msgBufferPool.released);
+}
+
+void test_new_sms_supersedes_previous_alert()
+{
+  TEST_ASSERT_TRUE(alert_sms_start(TEST_NUMBER, TEST_SMS_TEXT, TEST_STAMP, 0));
+  TEST_ASSERT_NOT_NULL(currentAlert);
+  uint32_t firstId = currentAlert->id;
+
+  TEST_ASSERT_TRUE(alert_sms_start(TEST_NUMBER, TEST_SMS_TEXT, TEST_STAMP, 0));
+  TEST_ASSERT_NOT_NULL(currentAlert);
+  TEST_ASSERT_EQUAL_UINT32(firstId + 1, currentAlert->id);
+  TEST_ASSERT_EQUAL_UINT8(1, alertPool.inUse);
+
+  alert_finish();
+  TEST_ASSERT_EQUAL_UINT8(0, alertPool.inUse);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_alert_cycles_keep_heap_flat);
+  RUN_TEST(test_heap_hook_counts_malloc);
+  RUN_TEST(test_exhausted_pool_fails_without_leaking);
+  RUN_TEST(test_new_sms_supersedes_previous_alert);
+  return UNITY_END();
+}
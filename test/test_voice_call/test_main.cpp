@@ -0,0 +1,414 @@
+/*
+ * Call state machine against a fake module: response lines are fed byte by
+ * byte through the SimPort line reader, AT commands are recorded.
+ *
+ * Run with: pio test -e native
+ */
+
+#include <AlertPool.h>
+#include <AlertSms.h>
+#include <SimPort.h>
+#include <VoiceCall.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define TEST_NUMBER "+84909483187"
+#define SENT_MAX 32
+
+// Fake module
+static char sent[SENT_MAX][AT_CMD_MAX_LEN];
+static uint8_t sentCount = 0;
+static unsigned long fakeNow = 0;
+static bool echoNoCarrierOnHangUp = false; // Module reports NO CARRIER while ATH is being sent
+static uint8_t unhandledLines = 0;
+static const char *injectOnSmsPrompt = nullptr; // Line the module reports right after AT+CMGS
+
+// Application callbacks
+static uint8_t answeredCount = 0;
+static uint8_t acknowledgedCount = 0;
+static char acknowledgedKey = 0;
+static uint8_t endedCount = 0;
+static char endedReason[SIM_LINE_MAX_LEN];
+static uint8_t sentAtEnd = 0; // Commands sent when ended() ran
+
+static void feed(const char *text)
+{
+  for (const char *p = text; *p != '\0'; p++)
+  {
+    sim_port_feed(*p);
+  }
+  sim_port_feed('\r');
+  sim_port_feed('\n');
+}
+
+static bool fake_send_line(const char *cmd)
+{
+  if (sentCount < SENT_MAX)
+  {
+    snprintf(sent[sentCount++], AT_CMD_MAX_LEN, "%s", cmd);
+  }
+  // Like sim_at_cmd(): responses are read (and handled) while sending
+  if (echoNoCarrierOnHangUp && strcmp(cmd, "ATH") == 0)
+  {
+    feed("NO CARRIER");
+  }
+  if (injectOnSmsPrompt != nullptr && strncmp(cmd, "AT+CMGS=", 8) == 0)
+  {
+    feed(injectOnSmsPrompt);
+  }
+  return true;
+}
+
+static bool fake_send_byte(char c)
+{
+  (void)c;
+  return true;
+}
+
+static void fake_wait_ms(unsigned long ms)
+{
+  fakeNow += ms;
+}
+
+static unsigned long fake_now_ms()
+{
+  return fakeNow;
+}
+
+static void fake_log(const char *text)
+{
+  (void)text;
+}
+
+static void fake_line_handler(const char *line)
+{
+  if (!voice_call_handle_line(line))
+  {
+    unhandledLines++;
+  }
+}
+
+static void on_answered()
+{
+  answeredCount++;
+}
+
+static void on_acknowledged(char key)
+{
+  acknowledgedCount++;
+  acknowledgedKey = key;
+}
+
+static void on_ended(const char *reason)
+{
+  endedCount++;
+  snprintf(endedReason, sizeof(endedReason), "%s", reason);
+  sentAtEnd = sentCount;
+}
+
+static const SimPort fakePort = {fake_send_line, fake_send_byte, fake_wait_ms, fake_now_ms, fake_log};
+static const VoiceCallEvents events = {on_answered, on_acknowledged, on_ended};
+
+// Number of recorded commands equal to cmd
+static uint8_t count_sent(const char *cmd)
+{
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < sentCount; i++)
+  {
+    if (strcmp(sent[i], cmd) == 0)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+static const char *last_sent()
+{
+  return sentCount > 0 ? sent[sentCount - 1] : "";
+}
+
+void setUp()
+{
+  sentCount = 0;
+  fakeNow = 1000;
+  echoNoCarrierOnHangUp = false;
+  unhandledLines = 0;
+  injectOnSmsPrompt = nullptr;
+  answeredCount = 0;
+  acknowledgedCount = 0;
+  acknowledgedKey = 0;
+  endedCount = 0;
+  endedReason[0] = '\0';
+  sentAtEnd = 0;
+  callInProgress = false;
+  callAnswered = false;
+  sim_port_begin(&fakePort, fake_line_handler);
+  sim_port_set_prompt(false);
+  voice_call_begin(&events);
+}
+
+void tearDown()
+{
+  voice_call_end("test done", false);
+  voice_call_process(); // Flush any hang-up held back by the test
+  alert_finish();
+}
+
+static void dial_and_answer()
+{
+  voice_call_dial(TEST_NUMBER);
+  fakeNow += 5000;
+  feed("VOICE CALL: BEGIN");
+}
+
+void test_configure_routes_audio_to_remote_party()
+{
+  voice_call_configure_module();
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+CLCC=1"));
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+DDET=1"));
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+CDTAM=1"));
+}
+
+void test_answer_plays_alert_and_ack_hangs_up()
+{
+  voice_call_dial(TEST_NUMBER);
+  TEST_ASSERT_EQUAL_STRING("ATD" TEST_NUMBER ";", last_sent());
+  TEST_ASSERT_TRUE(callInProgress);
+
+  feed("VOICE CALL: BEGIN");
+  TEST_ASSERT_EQUAL_UINT8(1, answeredCount);
+  TEST_ASSERT_EQUAL_STRING("AT+CTTS=2,\"" VOICE_ALERT_TTS_TEXT "\"", last_sent());
+
+  feed("+RXDTMF: 5"); // Wrong key is ignored
+  TEST_ASSERT_EQUAL_UINT8(0, acknowledgedCount);
+  TEST_ASSERT_TRUE(callInProgress);
+
+  char ack[] = "+RXDTMF: 1";
+  ack[9] = VOICE_ACK_KEY;
+  feed(ack);
+  TEST_ASSERT_EQUAL_UINT8(1, acknowledgedCount);
+  TEST_ASSERT_EQUAL(VOICE_ACK_KEY, acknowledgedKey);
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("acknowledged", endedReason);
+  TEST_ASSERT_FALSE(callInProgress);
+  TEST_ASSERT_FALSE(callAnswered);
+
+  // Playback stopped and call hung up, after the application was told
+  TEST_ASSERT_EQUAL_STRING("AT+CTTS=0", sent[sentCount - 2]);
+  TEST_ASSERT_EQUAL_STRING("ATH", sent[sentCount - 1]);
+  TEST_ASSERT_EQUAL_UINT8(sentCount - 2, sentAtEnd);
+  TEST_ASSERT_EQUAL_UINT8(0, unhandledLines);
+}
+
+void test_hang_up_echo_ends_call_once()
+{
+  echoNoCarrierOnHangUp = true;
+  dial_and_answer();
+
+  char ack[] = "+RXDTMF: 1";
+  ack[9] = VOICE_ACK_KEY;
+  feed(ack);
+
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("acknowledged", endedReason);
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("ATH"));
+  TEST_ASSERT_FALSE(callInProgress);
+}
+
+void test_replay_stops_after_repeats()
+{
+  dial_and_answer();
+  for (uint8_t i = 0; i < VOICE_PLAY_REPEATS + 2; i++)
+  {
+    feed("+CTTS: 0");
+  }
+
+  TEST_ASSERT_EQUAL_UINT8(VOICE_PLAY_REPEATS, voicePlayCount);
+  TEST_ASSERT_EQUAL_UINT8(VOICE_PLAY_REPEATS, count_sent("AT+CTTS=2,\"" VOICE_ALERT_TTS_TEXT "\""));
+  TEST_ASSERT_TRUE(callInProgress);
+}
+
+void test_no_carrier_ends_without_hang_up()
+{
+  dial_and_answer();
+  feed("NO CARRIER");
+
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("NO CARRIER", endedReason);
+  TEST_ASSERT_EQUAL_UINT8(0, count_sent("ATH"));
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+CTTS=0"));
+
+  feed("+CTTS: 0"); // Late playback report must not replay into a finished call
+  TEST_ASSERT_EQUAL_UINT8(1, voicePlayCount);
+}
+
+void test_dtmf_before_answer_is_ignored()
+{
+  voice_call_dial(TEST_NUMBER);
+  char ack[] = "+RXDTMF: 1";
+  ack[9] = VOICE_ACK_KEY;
+  feed(ack);
+
+  TEST_ASSERT_EQUAL_UINT8(0, acknowledgedCount);
+  TEST_ASSERT_TRUE(callInProgress);
+}
+
+void test_clcc_active_and_released()
+{
+  voice_call_dial(TEST_NUMBER);
+  feed("+CLCC: 1,0,3,0,0,\"" TEST_NUMBER "\",145"); // Alerting
+  TEST_ASSERT_EQUAL_UINT8(0, answeredCount);
+
+  feed("+CLCC: 1,0,0,0,0,\"" TEST_NUMBER "\",145");
+  feed("VOICE CALL: BEGIN"); // Both reports of the same answer
+  TEST_ASSERT_EQUAL_UINT8(1, answeredCount);
+  TEST_ASSERT_EQUAL_UINT8(1, voicePlayCount);
+
+  feed("+CLCC: 1,0,6,0,0,\"" TEST_NUMBER "\",145");
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("released", endedReason);
+}
+
+void test_unanswered_call_times_out()
+{
+  voice_call_dial(TEST_NUMBER);
+  fakeNow += CALL_DURATION - 1;
+  voice_call_process();
+  TEST_ASSERT_TRUE(callInProgress);
+
+  fakeNow += 1;
+  voice_call_process();
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("not answered", endedReason);
+  TEST_ASSERT_EQUAL_STRING("ATH", last_sent());
+  TEST_ASSERT_EQUAL_UINT8(0, count_sent("AT+CTTS=0"));
+}
+
+void test_unacknowledged_call_times_out()
+{
+  dial_and_answer();
+  fakeNow += CALL_DURATION; // Ring timeout no longer applies once answered
+  voice_call_process();
+  TEST_ASSERT_TRUE(callInProgress);
+
+  fakeNow += VOICE_ACK_WINDOW - CALL_DURATION;
+  voice_call_process();
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_EQUAL_STRING("answered, no acknowledgment", endedReason);
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+CTTS=0"));
+  TEST_ASSERT_EQUAL_STRING("ATH", last_sent());
+}
+
+void test_overlong_command_is_not_sent()
+{
+  char number[AT_CMD_MAX_LEN];
+  memset(number, '9', sizeof(number) - 1);
+  number[sizeof(number) - 1] = '\0';
+  uint32_t truncatedBefore = atTruncatedCount;
+
+  TEST_ASSERT_FALSE(sim_port_sendf("ATD%s;", number));
+  TEST_ASSERT_EQUAL_UINT8(0, sentCount);
+  TEST_ASSERT_EQUAL_UINT32(truncatedBefore + 1, atTruncatedCount);
+  TEST_ASSERT_EQUAL_UINT8(0, atTxnPool.inUse);
+
+  // Exactly AT_CMD_MAX_LEN - 1 characters still fits
+  number[AT_CMD_MAX_LEN - 5] = '\0';
+  TEST_ASSERT_TRUE(sim_port_sendf("ATD%s;", number));
+  TEST_ASSERT_EQUAL_UINT8(1, sentCount);
+}
+
+void test_overlong_line_is_dropped()
+{
+  char line[SIM_LINE_MAX_LEN + 8];
+  memset(line, 'x', sizeof(line) - 1);
+  line[sizeof(line) - 1] = '\0';
+  feed(line);
+  TEST_ASSERT_EQUAL_UINT8(0, unhandledLines);
+
+  feed("OK");
+  TEST_ASSERT_EQUAL_UINT8(1, unhandledLines);
+}
+
+// Index of the first recorded command equal to cmd (SENT_MAX if none)
+static uint8_t find_sent(const char *cmd)
+{
+  for (uint8_t i = 0; i < sentCount; i++)
+  {
+    if (strcmp(sent[i], cmd) == 0)
+    {
+      return i;
+    }
+  }
+  return SENT_MAX;
+}
+
+void test_answer_during_sms_defers_voice_alert()
+{
+  voice_call_dial(TEST_NUMBER);
+  injectOnSmsPrompt = "VOICE CALL: BEGIN";
+  alert_sms_send(TEST_NUMBER, "Test SMS");
+
+  // Answer seen at the > prompt: nothing may be sent between AT+CMGS and the text
+  TEST_ASSERT_EQUAL_UINT8(1, answeredCount);
+  TEST_ASSERT_EQUAL_UINT8(0, voicePlayCount);
+  TEST_ASSERT_EQUAL_STRING("Test SMS", sent[find_sent("AT+CMGS=\"" TEST_NUMBER "\"") + 1]);
+  TEST_ASSERT_EQUAL_STRING("Test SMS", last_sent());
+
+  voice_call_process();
+  TEST_ASSERT_EQUAL_UINT8(1, voicePlayCount);
+  TEST_ASSERT_EQUAL_STRING("AT+CTTS=2,\"" VOICE_ALERT_TTS_TEXT "\"", last_sent());
+  TEST_ASSERT_TRUE(callInProgress);
+}
+
+void test_ack_during_sms_defers_hang_up()
+{
+  dial_and_answer();
+  char ack[] = "+RXDTMF: 1";
+  ack[9] = VOICE_ACK_KEY;
+  injectOnSmsPrompt = ack;
+  alert_sms_send(TEST_NUMBER, "Test SMS");
+
+  TEST_ASSERT_EQUAL_UINT8(1, acknowledgedCount);
+  TEST_ASSERT_EQUAL_UINT8(1, endedCount);
+  TEST_ASSERT_FALSE(callInProgress);
+  TEST_ASSERT_EQUAL_UINT8(0, count_sent("ATH"));
+  TEST_ASSERT_EQUAL_STRING("Test SMS", last_sent());
+
+  voice_call_process();
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("ATH"));
+  TEST_ASSERT_EQUAL_STRING("ATH", last_sent());
+}
+
+void test_sms_refused_while_call_in_progress()
+{
+  TEST_ASSERT_TRUE(alert_sms_start(TEST_NUMBER, "Power lost", "00:00:01", 0));
+  Alert *callAlert = currentAlert;
+  TEST_ASSERT_NOT_NULL(callAlert);
+  voice_call_dial(TEST_NUMBER);
+
+  TEST_ASSERT_FALSE(alert_sms_start(TEST_NUMBER, "Power lost", "00:00:06", 5000000));
+  TEST_ASSERT_EQUAL_PTR(callAlert, currentAlert);
+  TEST_ASSERT_EQUAL_UINT8(1, count_sent("AT+CMGF=1"));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_configure_routes_audio_to_remote_party);
+  RUN_TEST(test_answer_plays_alert_and_ack_hangs_up);
+  RUN_TEST(test_hang_up_echo_ends_call_once);
+  RUN_TEST(test_replay_stops_after_repeats);
+  RUN_TEST(test_no_carrier_ends_without_hang_up);
+  RUN_TEST(test_dtmf_before_answer_is_ignored);
+  RUN_TEST(test_clcc_active_and_released);
+  RUN_TEST(test_unanswered_call_times_out);
+  RUN_TEST(test_unacknowledged_call_times_out);
+  RUN_TEST(test_overlong_command_is_not_sent);
+  RUN_TEST(test_overlong_line_is_dropped);
+  RUN_TEST(test_answer_during_sms_defers_voice_alert);
+  RUN_TEST(test_ack_during_sms_defers_hang_up);
+  RUN_TEST(test_sms_refused_while_call_in_progress);
+  return UNITY_END();
+}